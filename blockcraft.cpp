@@ -1,12 +1,345 @@
 #include "app/client.hpp"
+#include "blocks/chunk.hpp"
+#include "blocks/chunk_codec.hpp"
+#include "blocks/chunk_manager.hpp"
+#include "blocks/chunk_mesher.hpp"
+#include "blocks/padded_chunk.hpp"
+#include "blocks/palette_storage.hpp"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <iostream>
+#include <optional>
+#include <random>
 #include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Headless report of the binary mesher's output per level of detail, for every chunk within radius of the origin
+static void report_lod_vertex_counts(int radius) {
+    std::vector<Chunk> chunks;
+    std::unordered_map<glm::ivec2, size_t> chunk_index_map;
+    for (int x = -radius; x <= radius; x++) {
+        for (int y = -radius; y <= radius; y++) {
+            if (glm::floor(glm::length(glm::vec2(x, y))) > radius) {
+                continue;
+            }
+            Chunk chunk({ x, y }, 2345);
+            chunk.generate_blocks_from_seed();
+            chunk_index_map[{ x, y }] = chunks.size();
+            chunks.push_back(std::move(chunk));
+        }
+    }
+
+    auto count_vertices = [&](ChunkMesher& mesher) {
+        size_t n_quads = 0;
+        for (const Chunk& chunk : chunks) {
+            n_quads += mesher.count_quads(PaddedChunk(chunk, chunks, chunk_index_map), MeshingMode::Binary);
+        }
+        return n_quads * VERTICES_PER_QUAD;
+    };
+
+    ChunkMesher mesher;
+    std::printf("%zu chunks within %d chunks of the origin\n", chunks.size(), radius);
+
+    std::array<size_t, MAX_LOD + 1> lod_vertices{};
+    for (int lod = 0; lod <= MAX_LOD; lod++) {
+        for (Chunk& chunk : chunks) {
+            chunk.set_lod(lod);
+        }
+        lod_vertices[lod] = count_vertices(mesher);
+        std::printf("LOD %d (%dx%dx%d cells): %zu vertices, %.1f per chunk, %.1f%% of LOD 0\n",
+                    lod, 1 << lod, 1 << lod, 1 << lod, lod_vertices[lod],
+                    static_cast<double>(lod_vertices[lod]) / chunks.size(),
+                    100.0 * lod_vertices[lod] / lod_vertices[0]);
+    }
+
+    // levels picked by distance from the origin, the way ChunkManager picks them from the camera
+    std::array<size_t, MAX_LOD + 1> lod_chunks{};
+    for (Chunk& chunk : chunks) {
+        int dist = glm::floor(glm::length(glm::vec2(chunk.get_chunk_coords())));
+        int lod = 0;
+        while (lod < MAX_LOD && dist >= LOD_DISTANCES[lod]) {
+            lod++;
+        }
+        chunk.set_lod(lod);
+        lod_chunks[lod]++;
+    }
+    size_t selected_vertices = count_vertices(mesher);
+    std::printf("Distance based selection: %zu vertices, %.1f%% of LOD 0\n",
+                selected_vertices, 100.0 * selected_vertices / lod_vertices[0]);
+    for (int lod = 0; lod <= MAX_LOD; lod++) {
+        std::printf("    %zu chunks at LOD %d\n", lod_chunks[lod], lod);
+    }
+}
+
+// Headless report of the time taken to mesh every chunk within radius of the origin: the padded snapshot of the chunk
+// and its neighbors, then each meshing mode on that snapshot. Quads are counted rather than packed into records,
+// which needs the textures
+static void report_meshing_time(int radius) {
+    using Clock = std::chrono::steady_clock;
+    auto elapsed_ms = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    std::vector<Chunk> chunks;
+    std::unordered_map<glm::ivec2, size_t> chunk_index_map;
+    for (int x = -radius; x <= radius; x++) {
+        for (int y = -radius; y <= radius; y++) {
+            if (glm::floor(glm::length(glm::vec2(x, y))) > radius) {
+                continue;
+            }
+            Chunk chunk({ x, y }, 2345);
+            chunk.generate_blocks_from_seed();
+            chunk_index_map[{ x, y }] = chunks.size();
+            chunks.push_back(std::move(chunk));
+        }
+    }
+
+    ChunkMesher mesher;
+    std::vector<PaddedChunk> padded_chunks;
+    padded_chunks.reserve(chunks.size());
+
+    auto start = Clock::now();
+    for (const Chunk& chunk : chunks) {
+        padded_chunks.emplace_back(chunk, chunks, chunk_index_map);
+    }
+    double snapshot_ms = elapsed_ms(start);
+    std::printf("%zu chunks within %d chunks of the origin\n", chunks.size(), radius);
+    std::printf("Padded snapshot: %.3f ms per chunk\n", snapshot_ms / chunks.size());
+
+    const std::array<std::pair<MeshingMode, const char*>, 3> modes = {{
+        { MeshingMode::PerFace, "per-face" },
+        { MeshingMode::Greedy, "greedy" },
+        { MeshingMode::Binary, "binary" },
+    }};
+    for (auto [meshing_mode, name] : modes) {
+        size_t n_quads = 0;
+        start = Clock::now();
+        for (const PaddedChunk& padded_chunk : padded_chunks) {
+            n_quads += mesher.count_quads(padded_chunk, meshing_mode);
+        }
+        double mesh_ms = elapsed_ms(start);
+        std::printf("%s meshing: %.3f ms per chunk, %.0f quads per chunk\n",
+                    name, mesh_ms / chunks.size(), static_cast<double>(n_quads) / chunks.size());
+    }
+}
+
+// Headless report of block storage for every chunk within radius of the origin: the memory used by palette storage
+// against plain Block arrays, how many sections use each index width, and the time taken by the main access patterns
+// with the BLOCK_LAYOUT the game was built with
+static void report_block_storage(int radius) {
+    using Clock = std::chrono::steady_clock;
+    auto elapsed_ms = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    std::vector<Chunk> chunks;
+    std::unordered_map<glm::ivec2, size_t> chunk_index_map;
+    double generate_ms = 0.0;
+    for (int x = -radius; x <= radius; x++) {
+        for (int y = -radius; y <= radius; y++) {
+            if (glm::floor(glm::length(glm::vec2(x, y))) > radius) {
+                continue;
+            }
+            Chunk chunk({ x, y }, 2345);
+            auto start = Clock::now();
+            chunk.generate_blocks_from_seed();
+            generate_ms += elapsed_ms(start);
+
+            chunk_index_map[{ x, y }] = chunks.size();
+            chunks.push_back(std::move(chunk));
+        }
+    }
+
+    size_t storage_bytes = 0;
+    std::array<size_t, 17> sections_per_width{};
+    for (const Chunk& chunk : chunks) {
+        for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+            const PaletteStorage& storage = chunk.get_section(section_index).get_storage();
+            storage_bytes += sizeof(PaletteStorage) + storage.memory_usage();
+            sections_per_width[storage.get_bits_per_index()]++;
+        }
+    }
+
+    size_t n_chunks = chunks.size();
+    size_t raw_bytes = n_chunks * BLOCKS_PER_CHUNK * sizeof(Block);
+    std::printf("%zu chunks within %d chunks of the origin\n", n_chunks, radius);
+    std::printf("Block arrays: %.1f KiB per chunk\n", raw_bytes / 1024.0 / n_chunks);
+    std::printf("Palette storage: %.1f KiB per chunk, %.1fx smaller\n",
+                storage_bytes / 1024.0 / n_chunks, static_cast<double>(raw_bytes) / storage_bytes);
+    for (int bits = 0; bits <= 16; bits++) {
+        if (sections_per_width[bits] > 0) {
+            std::printf("    %zu sections with %d bit indices\n", sections_per_width[bits], bits);
+        }
+    }
+
+    // every block in z-major order, as sent to clients
+    auto start = Clock::now();
+    size_t n_solid = 0;
+    for (const Chunk& chunk : chunks) {
+        for (Block block : chunk.get_blocks()) {
+            n_solid += block.type != Block::Type::AIR;
+        }
+    }
+    double read_ms = elapsed_ms(start);
+
+    // the snapshot meshing reads, including the borders from the neighbors
+    start = Clock::now();
+    for (const Chunk& chunk : chunks) {
+        PaddedChunk padded_chunk(chunk, chunks, chunk_index_map);
+    }
+    double snapshot_ms = elapsed_ms(start);
+
+    // rays from just above the ground in random directions, far enough from the edge to stay within loaded chunks
+    constexpr int N_RAYS = 100000;
+    constexpr float RAY_DISTANCE = 32.0f;
+    std::mt19937 rng(2345);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    float ray_extent = std::max(radius - 3, 0) * static_cast<float>(CHUNK_LENGTH) / 1.5f;
+    int n_hits = 0;
+    start = Clock::now();
+    for (int i = 0; i < N_RAYS; i++) {
+        glm::vec2 column = glm::vec2(unit(rng), unit(rng)) * ray_extent;
+        float ground_level = static_cast<float>(Chunk::get_ground_level(glm::floor(column), 2345));
+        glm::vec3 position(column, ground_level + 2.0f + 8.0f * std::abs(unit(rng)));
+        glm::vec3 direction = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 0.0f, -0.5f));
+        n_hits += Chunk::cast_ray(position, direction, RAY_DISTANCE, false, chunks, chunk_index_map).has_value();
+    }
+    double raycast_ms = elapsed_ms(start);
+
+    std::printf("Access times with the %s layout:\n", BLOCK_LAYOUT_NAME);
+    std::printf("    generate: %.3f ms per chunk\n", generate_ms / n_chunks);
+    std::printf("    read every block in z-major order: %.3f ms per chunk (%zu solid)\n", read_ms / n_chunks, n_solid);
+    std::printf("    padded snapshot for meshing: %.3f ms per chunk\n", snapshot_ms / n_chunks);
+    std::printf("    raycast up to %.0f blocks: %.2f us per ray (%d of %d hit)\n",
+                RAY_DISTANCE, 1000.0 * raycast_ms / N_RAYS, n_hits, N_RAYS);
+}
+
+// Headless report of the ChunkData encoding for every chunk within radius of the origin: sizes with and without the
+// LZ pass, encode and decode throughput, and a check that every chunk decodes to the generated blocks. Returns nonzero
+// if a chunk did not
+static int report_chunk_encoding(int radius) {
+    using Clock = std::chrono::steady_clock;
+
+    size_t n_chunks = 0;
+    size_t n_mismatches = 0;
+    size_t raw_bytes = 0;
+    std::array<size_t, 2> encoded_bytes{};
+    std::array<double, 2> encode_ms{};
+    std::array<double, 2> decode_ms{};
+
+    for (int x = -radius; x <= radius; x++) {
+        for (int y = -radius; y <= radius; y++) {
+            if (glm::floor(glm::length(glm::vec2(x, y))) > radius) {
+                continue;
+            }
+            Chunk chunk({ x, y }, 2345);
+            chunk.generate_blocks_from_seed();
+            std::vector<Block> blocks = chunk.get_blocks();
+            n_chunks++;
+            raw_bytes += blocks.size() * sizeof(Block);
+
+            for (int compress = 0; compress <= 1; compress++) {
+                auto start = Clock::now();
+                std::vector<std::byte> encoded = encode_chunk_blocks(blocks, compress);
+                auto encoded_time = Clock::now();
+                std::optional<std::vector<Block>> decoded = decode_chunk_blocks(encoded.data(), encoded.size());
+                auto decoded_time = Clock::now();
+
+                encoded_bytes[compress] += encoded.size();
+                encode_ms[compress] += std::chrono::duration<double, std::milli>(encoded_time - start).count();
+                decode_ms[compress] += std::chrono::duration<double, std::milli>(decoded_time - encoded_time).count();
+
+                bool matches = decoded && std::equal(blocks.begin(), blocks.end(), decoded->begin(), decoded->end(),
+                                                     [](Block a, Block b) { return a.type == b.type; });
+                n_mismatches += !matches;
+            }
+        }
+    }
+
+    std::printf("%zu chunks within %d chunks of the origin, %.1f MiB as raw blocks\n",
+                n_chunks, radius, raw_bytes / (1024.0 * 1024.0));
+    const char* names[] = { "palette + RLE", "palette + RLE + LZ" };
+    for (int compress = 0; compress <= 1; compress++) {
+        double raw_mib = raw_bytes / (1024.0 * 1024.0);
+        std::printf("%s: %zu bytes per chunk, %.1fx smaller; encode %.0f MiB/s, decode %.0f MiB/s of raw blocks\n",
+                    names[compress], encoded_bytes[compress] / n_chunks,
+                    static_cast<double>(raw_bytes) / encoded_bytes[compress],
+                    raw_mib / (encode_ms[compress] / 1000.0), raw_mib / (decode_ms[compress] / 1000.0));
+    }
+    std::printf("Round trips that did not reproduce the generated blocks: %zu\n", n_mismatches);
+    return n_mismatches > 0 ? 1 : 0;
+}
 
 int main(int argc, char** argv) {
+    // offscreen benchmark of the renderer, runs without a server
+    if (argc >= 2 && std::string(argv[1]) == "--benchmark") {
+        int frames = argc >= 3 ? std::stoi(argv[2]) : 300;
+        if (frames <= 0) {
+            std::cout << "Invalid number of frames" << std::endl;
+            return 0;
+        }
+
+        ClientApplication application(1920, 1200, "", 0, frames);
+        application.run();
+        return 0;
+    }
+
+    if (argc >= 2 && std::string(argv[1]) == "--lod-report") {
+        int radius = argc >= 3 ? std::stoi(argv[2]) : 32;
+        if (radius < 0) {
+            std::cout << "Invalid radius" << std::endl;
+            return 0;
+        }
+
+        report_lod_vertex_counts(radius);
+        return 0;
+    }
+
+    if (argc >= 2 && std::string(argv[1]) == "--mesh-report") {
+        int radius = argc >= 3 ? std::stoi(argv[2]) : 8;
+        if (radius < 0) {
+            std::cout << "Invalid radius" << std::endl;
+            return 0;
+        }
+
+        report_meshing_time(radius);
+        return 0;
+    }
+
+    if (argc >= 2 && std::string(argv[1]) == "--storage-report") {
+        int radius = argc >= 3 ? std::stoi(argv[2]) : 8;
+        if (radius < 0) {
+            std::cout << "Invalid radius" << std::endl;
+            return 0;
+        }
+
+        report_block_storage(radius);
+        return 0;
+    }
+
+    if (argc >= 2 && std::string(argv[1]) == "--codec-report") {
+        int radius = argc >= 3 ? std::stoi(argv[2]) : 8;
+        if (radius < 0) {
+            std::cout << "Invalid radius" << std::endl;
+            return 0;
+        }
+
+        return report_chunk_encoding(radius);
+    }
+
     if (argc != 1 && argc != 3) {
-        std::cout << "Usage: blockcraft <hostname> <port>\nJoins localhost:50000 by default if no arguments are supplied." << std::endl;
+        std::cout << "Usage: blockcraft <hostname> <port>\n       blockcraft --benchmark [frames]\n"
+                     "       blockcraft --lod-report [radius]\n       blockcraft --mesh-report [radius]\n"
+                     "       blockcraft --storage-report [radius]\n"
+                     "       blockcraft --codec-report [radius]\n"
+                     "Joins localhost:50000 by default if no arguments are supplied." << std::endl;
         return 0;
     }
 
@@ -1,11 +1,19 @@
 #include "blocks/chunk.hpp"
+#include "blocks/chunk_store.hpp"
+#include "networking/chunk_service.hpp"
+#include "blocks/far_terrain.hpp"
 #include "networking/server.hpp"
+#include "utils/logger.hpp"
 
+#include <chrono>
+#include <cstddef>
 #include <iostream>
+#include <optional>
 
 int main(int argc, char** argv) {
-    if (argc != 1 && argc != 2) {
-        std::cout << "Usage: blockcraft_server <port>\nHosts server on port 50000 by default if no arguments are supplied." << std::endl;
+    if (argc > 3) {
+        std::cout << "Usage: blockcraft_server <port> [chunk cache MiB]\n"
+                     "Hosts server on port 50000 with a 64 MiB chunk cache by default if no arguments are supplied." << std::endl;
         return 0;
     }
 
@@ -22,7 +30,20 @@ int main(int argc, char** argv) {
     }
     uint16_t port = static_cast<uint16_t>(temp_port);
 
+    size_t cache_budget = ChunkStore::DEFAULT_MEMORY_BUDGET;
+    if (argc == 3) {
+        int cache_mib = std::stoi(argv[2]);
+        if (cache_mib < 0) {
+            std::cout << "Invalid chunk cache size" << std::endl;
+            return 0;
+        }
+        cache_budget = static_cast<size_t>(cache_mib) * 1024 * 1024;
+    }
+
+    // the two pools share the cores: a few threads for the sessions and the rest for generating chunks
+    int num_network_threads = ServerInterface::default_num_threads();
     ServerInterface server(port);
+    ChunkService chunk_service(cache_budget, ChunkService::default_num_threads(num_network_threads));
 
     server.register_packet_handler(PacketType::Ping,
         [&server](std::shared_ptr<Session> session, Packet){
@@ -31,23 +52,40 @@ int main(int argc, char** argv) {
     });
 
     server.register_packet_handler(PacketType::ChunkRequest,
-        [&server](std::shared_ptr<Session> session, Packet packet){
-            ChunkRequest chunk_request = ChunkRequest::deserialize(std::move(packet));
-
-            Chunk chunk(chunk_request.chunk_coords, chunk_request.seed);
-            chunk.generate_blocks_from_seed();
+        [&chunk_service](std::shared_ptr<Session> session, Packet packet){
+            std::optional<ChunkRequest> chunk_request = ChunkRequest::deserialize(std::move(packet));
+            if (!chunk_request.has_value()) {
+                log_error("[Server] Dropping a chunk request of the wrong size from %s",
+                          session->remote_endpoint().address().to_string().c_str());
+                return;
+            }
+            chunk_service.request(std::move(session), *chunk_request);
+    });
 
-            ChunkData chunk_data{
-                chunk_request.chunk_coords,
-                chunk_request.seed,
-                chunk.get_blocks(),
-            };
+    server.register_packet_handler(PacketType::FarTerrainRequest,
+        [&chunk_service](std::shared_ptr<Session> session, Packet packet){
+            std::optional<FarTerrainRequest> request = FarTerrainRequest::deserialize(std::move(packet));
+            if (!request.has_value()) {
+                log_error("[Server] Dropping a far terrain request of the wrong size from %s",
+                          session->remote_endpoint().address().to_string().c_str());
+                return;
+            }
+            chunk_service.request_far_terrain(std::move(session), *request);
+    });
 
-            server.send_to(session, chunk_data.serialize());
+    // chunk cache counters, only while chunks are being requested
+    size_t logged_requests = 0;
+    server.set_tick_handler(std::chrono::seconds(10), [&chunk_service, &logged_requests]() {
+        ChunkServiceStats stats = chunk_service.get_stats();
+        size_t requests = stats.store.hits + stats.store.misses + stats.coalesced;
+        if (requests != logged_requests) {
+            log_debug("[Server] Chunk cache: %zu hits, %zu misses, %zu coalesced, %zu in flight, %zu evictions; "
+                      "%zu chunks, %zu of %zu KiB; %zu far terrain tiles queued",
+                      stats.store.hits, stats.store.misses, stats.coalesced, stats.in_flight, stats.store.evictions,
+                      stats.n_chunks, stats.memory_usage / 1024, stats.memory_budget / 1024, stats.far_tiles_queued);
+            logged_requests = requests;
+        }
     });
 
-    using namespace std::chrono_literals;
-    while (true) {
-        server.poll();
-    }
+    server.run(num_network_threads);
 }
@@ -1,15 +1,56 @@
 #version 460 core
-layout (location = 0) in uint vData;
 
-uniform mat4 model;
+// lets the vertex shader pick the cascade layer; without either, ShadowMap attaches one layer at a time
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+
+// same quad records and expansion as voxel.vert, without the ambient occlusion
+layout (std430, binding = 1) readonly buffer ChunkQuads {
+    uvec2 quads[];
+};
+
+// w is the cascade the draw belongs to
+layout (std430, binding = 2) readonly buffer ChunkDraws {
+    vec4 origins[];
+};
+
+layout (std140, binding = 0) uniform CascadedShadowMap {
+    mat4 lightSpaceMatrices[16];
+    float cascadeSplitPlanes[16];
+    int numCascades;
+};
+
+const ivec3 face_corners[6][4] = {
+    { ivec3(0, 0, 1), ivec3(1, 0, 1), ivec3(1, 1, 1), ivec3(0, 1, 1) }, // TOP
+    { ivec3(0, 1, 0), ivec3(1, 1, 0), ivec3(1, 0, 0), ivec3(0, 0, 0) }, // BOTTOM
+    { ivec3(0, 1, 0), ivec3(0, 0, 0), ivec3(0, 0, 1), ivec3(0, 1, 1) }, // LEFT
+    { ivec3(1, 0, 0), ivec3(1, 1, 0), ivec3(1, 1, 1), ivec3(1, 0, 1) }, // RIGHT
+    { ivec3(0, 0, 0), ivec3(1, 0, 0), ivec3(1, 0, 1), ivec3(0, 0, 1) }, // FRONT
+    { ivec3(1, 1, 0), ivec3(0, 1, 0), ivec3(0, 1, 1), ivec3(1, 1, 1) }, // BACK
+};
+
+const ivec2 face_plane_axes[6] = { ivec2(0, 1), ivec2(0, 1), ivec2(1, 2), ivec2(1, 2), ivec2(0, 2), ivec2(0, 2) };
 
 void main()
 {
     // unpack data
-    int x = int((vData >> 27) & 0x1F);
-    int y = int((vData >> 22) & 0x1F);
-    int z = int((vData >> 14) & 0xFF);
-    vec4 vPos = vec4(x, y, z, 1.0);
+    uvec2 quad = quads[gl_VertexID / 4];
+    ivec3 quad_pos = ivec3(quad.x & 0xF, (quad.x >> 4) & 0xF, (quad.x >> 8) & 0xFF);
+    int face = int((quad.x >> 16) & 0x7);
+    ivec2 size = ivec2((quad.y >> 8) & 0xFF, (quad.y >> 16) & 0xFF) + 1;
+
+    // the corner order only changes the triangle split, which does not matter for depth
+    ivec3 offset = face_corners[face][gl_VertexID % 4];
+    ivec2 axes = face_plane_axes[face];
+    offset[axes.x] *= size.x;
+    offset[axes.y] *= size.y;
+    vec4 draw = origins[gl_DrawID];
+    int cascade = int(draw.w);
+    vec4 vPos = vec4(draw.xyz + vec3(quad_pos + offset), 1.0);
 
-    gl_Position = model * vPos;
+    gl_Position = lightSpaceMatrices[cascade] * vPos;
+#if defined(GL_ARB_shader_viewport_layer_array) || defined(GL_AMD_vertex_shader_layer)
+    // ignored when a single layer is attached
+    gl_Layer = cascade;
+#endif
 }
@@ -0,0 +1,57 @@
+#version 460 core
+
+flat in int textureIndex;
+in vec4 worldDistance;
+in vec3 fragPosWorldSpace;
+
+uniform sampler2DArray textureId;
+// non-zero for chunks drawn from their blocks, chunk (x, y) is at (x, y) modulo the texture size
+uniform usampler2D coveredChunks;
+uniform float renderRadius;
+uniform vec3 lightPos;
+
+out vec4 fragment;
+
+// must match CHUNK_LENGTH and CHUNK_WIDTH
+const vec2 CHUNK_SIZE = vec2(16.0, 16.0);
+
+float fog_factor(vec4 worldDistance) {
+    float dist = length(worldDistance.xyz);
+
+    float start = 0.8 * renderRadius;
+    float end = 0.9 * renderRadius;
+
+    if (dist > end) {
+        return 1.0;
+    } else if (dist < start) {
+        return 0.0;
+    } else {
+        return (dist - start) / (end - start);
+    }
+}
+
+void main() {
+    ivec2 chunk = ivec2(floor(fragPosWorldSpace.xy / CHUNK_SIZE));
+    ivec2 mask_size = textureSize(coveredChunks, 0);
+    if (texelFetch(coveredChunks, chunk & (mask_size - 1), 0).r != 0u) {
+        discard;
+    }
+
+    // flat shaded from the triangle's slope, heightfield normals always point up
+    vec3 normal = normalize(cross(dFdx(fragPosWorldSpace), dFdy(fragPosWorldSpace)));
+    normal *= sign(normal.z);
+
+    // same terms as voxel.frag without shadows: 1.0 for top faces and 0.8 for side faces, plus 0.5 when lit
+    float ambient = mix(0.8f, 1.0f, normal.z);
+    float sun = dot(normal, normalize(lightPos)) > 0.0f ? 0.5f : 0.0f;
+    vec4 light = vec4(vec3(ambient + sun), 1.0f);
+    vec4 fog_color = vec4(0.4f, 0.75f, 0.9f, 1.0f);
+
+    // the smallest mip level of the block texture, repeated once per block, so the distant ground does not shimmer
+    int level = textureQueryLevels(textureId) - 1;
+    ivec2 level_size = textureSize(textureId, level).xy;
+    ivec2 texel = ivec2(mod(floor(fragPosWorldSpace.xy * vec2(level_size)), vec2(level_size)));
+    vec4 color = texelFetch(textureId, ivec3(texel, textureIndex), level);
+
+    fragment = mix(light * color, fog_color, fog_factor(worldDistance));
+}
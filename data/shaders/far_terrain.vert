@@ -0,0 +1,38 @@
+#version 460 core
+
+// heightmap samples of all far terrain tiles, see blocks/far_terrain.hpp: the ground level in the low byte and the
+// texture index of the top block in the next one. gl_VertexID includes the base vertex of the tile's slot
+layout (std430, binding = 3) readonly buffer FarSamples {
+    uint samples[];
+};
+
+// world position of each tile of the multi-draw, see graphics/draw_indirect_buffer.hpp
+layout (std430, binding = 2) readonly buffer ChunkDraws {
+    vec4 origins[];
+};
+
+// must match FAR_TILE_SAMPLES and FAR_SAMPLE_SPACING
+const int TILE_SAMPLES = 17;
+const float SAMPLE_SPACING = 4.0;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec3 cameraPos;
+
+flat out int textureIndex;
+out vec4 worldDistance;
+out vec3 fragPosWorldSpace;
+
+void main() {
+    uint sample_data = samples[gl_VertexID];
+    int index = gl_VertexID % (TILE_SAMPLES * TILE_SAMPLES);
+    vec2 offset = vec2(index % TILE_SAMPLES, index / TILE_SAMPLES) * SAMPLE_SPACING;
+
+    // the surface is the top of the ground level block
+    vec4 modelPos = vec4(origins[gl_DrawID].xy + offset, float(sample_data & 0xFF) + 1.0, 1.0);
+
+    gl_Position = projection * view * modelPos;
+    textureIndex = int((sample_data >> 8) & 0xFF);
+    worldDistance = vec4(cameraPos, 1.0) - modelPos;
+    fragPosWorldSpace = modelPos.xyz;
+}
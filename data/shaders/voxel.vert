@@ -1,7 +1,16 @@
 #version 460 core
-layout (location = 0) in uint vData;
 
-uniform mat4 model;
+// QuadRecords of all chunks, see blocks/quad_record.hpp. Each quad is drawn as 4 vertices, gl_VertexID includes
+// the base vertex of the draw
+layout (std430, binding = 1) readonly buffer ChunkQuads {
+    uvec2 quads[];
+};
+
+// world position of each chunk of the multi-draw, see graphics/draw_indirect_buffer.hpp
+layout (std430, binding = 2) readonly buffer ChunkDraws {
+    vec4 origins[];
+};
+
 uniform mat4 view;
 uniform mat4 projection;
 uniform vec3 cameraPos;
@@ -15,25 +24,61 @@ out float ambientOcclusion;
 
 float ao_values[4] = { 0.512f, 0.64f, 0.8f, 1.0f };
 
+// corners of each face relative to the block position, in anti-clockwise order starting from the bottom left
+// when looking at the face; same order as the ambient occlusion values
+const ivec3 face_corners[6][4] = {
+    { ivec3(0, 0, 1), ivec3(1, 0, 1), ivec3(1, 1, 1), ivec3(0, 1, 1) }, // TOP
+    { ivec3(0, 1, 0), ivec3(1, 1, 0), ivec3(1, 0, 0), ivec3(0, 0, 0) }, // BOTTOM
+    { ivec3(0, 1, 0), ivec3(0, 0, 0), ivec3(0, 0, 1), ivec3(0, 1, 1) }, // LEFT
+    { ivec3(1, 0, 0), ivec3(1, 1, 0), ivec3(1, 1, 1), ivec3(1, 0, 1) }, // RIGHT
+    { ivec3(0, 0, 0), ivec3(1, 0, 0), ivec3(1, 0, 1), ivec3(0, 0, 1) }, // FRONT
+    { ivec3(1, 1, 0), ivec3(0, 1, 0), ivec3(0, 1, 1), ivec3(1, 1, 1) }, // BACK
+};
+
+// axes spanned by each face, the quad size is measured along these
+const ivec2 face_plane_axes[6] = { ivec2(0, 1), ivec2(0, 1), ivec2(1, 2), ivec2(1, 2), ivec2(0, 2), ivec2(0, 2) };
+
+// Texture coordinates follow the block grid so that GL_REPEAT tiles the texture once per block across merged quads
+vec2 tiled_tex_coord(vec3 pos, int face) {
+    // faces: TOP, BOTTOM, LEFT, RIGHT, FRONT, BACK
+    switch (face) {
+        case 0: return vec2(pos.x, pos.y);
+        case 1: return vec2(pos.x, -pos.y);
+        case 2: return vec2(-pos.y, pos.z);
+        case 3: return vec2(pos.y, pos.z);
+        case 4: return vec2(pos.x, pos.z);
+        default: return vec2(-pos.x, pos.z);
+    }
+}
+
 void main() {
     // unpack data
-    int x = int((vData >> 27) & 0x1F);
-    int y = int((vData >> 22) & 0x1F);
-    int z = int((vData >> 14) & 0xFF);
-    int u = int((vData >> 13) & 0x1);
-    int v = int((vData >> 12) & 0x1);
-    int texture_index = int((vData >> 5) & 0x7F);
-    int vFace = int((vData >> 2) & 0x7);
-    int ambient_occlusion = int(vData & 0x3);
+    uvec2 quad = quads[gl_VertexID / 4];
+    ivec3 quad_pos = ivec3(quad.x & 0xF, (quad.x >> 4) & 0xF, (quad.x >> 8) & 0xFF);
+    int vFace = int((quad.x >> 16) & 0x7);
+    int texture_index = int((quad.x >> 19) & 0x7F);
+    ivec4 ao = ivec4(quad.y & 0x3, (quad.y >> 2) & 0x3, (quad.y >> 4) & 0x3, (quad.y >> 6) & 0x3);
+    ivec2 size = ivec2((quad.y >> 8) & 0xFF, (quad.y >> 16) & 0xFF) + 1;
+
+    // have split in quad across from the darkest corner. The index buffer always splits along the first and third
+    // vertex, so starting from corner 1 instead of 0 selects the other diagonal
+    int first_corner = ao_values[ao[0]] + ao_values[ao[2]] > ao_values[ao[1]] + ao_values[ao[3]] ? 0 : 1;
+    int corner = (first_corner + gl_VertexID % 4) % 4;
 
-    vec4 modelPos = model * vec4(x, y, z, 1.0);
+    // stretch the unit face corners over the whole quad
+    ivec3 offset = face_corners[vFace][corner];
+    ivec2 axes = face_plane_axes[vFace];
+    offset[axes.x] *= size.x;
+    offset[axes.y] *= size.y;
+    vec3 pos = vec3(quad_pos + offset);
+
+    vec4 modelPos = vec4(origins[gl_DrawID].xyz + pos, 1.0);
 
     gl_Position = projection * view * modelPos;
-    texCoord = vec2(u, v);
+    texCoord = tiled_tex_coord(pos, vFace);
     textureIndex = texture_index;
     face = vFace;
     worldDistance = vec4(cameraPos, 1.0) - modelPos;
     fragPosWorldSpace = modelPos;
-    ambientOcclusion = ao_values[ambient_occlusion];
+    ambientOcclusion = ao_values[ao[corner]];
 }
-
@@ -1,13 +1,19 @@
 #pragma once
 
+#include "blocks/chunk_mesher.hpp"
+#include "blocks/far_terrain.hpp"
 #include "ecs/ecs.hpp"
 #include "events/event_manager.hpp"
+#include "graphics/draw_indirect_buffer.hpp"
+#include "graphics/shader_program.hpp"
 #include "graphics/window.hpp"
 #include "shadow_map.hpp"
 #include "systems/common.hpp"
 #include "networking/client.hpp"
 #include "networking/server.hpp"
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <queue>
@@ -17,9 +23,35 @@ constexpr float BLOCKS_PER_SECOND = 5.0f;
 constexpr int SHADOW_WIDTH = 2048;
 constexpr int SHADOW_HEIGHT = 2048;
 
+// Culling and streaming counters of the last frame
+struct RenderStats {
+    CullingStats chunks{};
+    // chunks inside the frustum that were culled because none of their sections are reachable
+    size_t n_occluded_chunks = 0;
+    // sections with quads in the drawn chunks that are not reachable from the camera and were left out
+    size_t n_occluded_sections = 0;
+    // opaque and translucent draw commands of the camera passes, one per visible range of sections
+    size_t n_section_draws = 0;
+    CullingStats shadow_casters{};
+    std::array<size_t, CASCADE_LEVELS> cascade_casters{};
+    // times each cascade was redrawn since the start
+    std::array<size_t, CASCADE_LEVELS> cascade_updates{};
+    size_t n_far_tiles = 0;
+    size_t far_terrain_memory = 0;
+};
+
+// Where the quads of each section of a chunk are in the shared quad buffer, see ChunkMeshData
+struct ChunkSectionRanges {
+    size_t first_quad = 0;
+    SectionQuadOffsets opaque_sections{};
+    SectionQuadOffsets translucent_sections{};
+};
+
 class ClientApplication {
 public:
-    ClientApplication(int width, int height, std::string hostname, uint16_t port);
+    // With benchmark_frames > 0 the client renders that many frames in a hidden window from locally generated
+    // chunks, then prints the CPU submit time per frame
+    ClientApplication(int width, int height, std::string hostname, uint16_t port, int benchmark_frames = 0);
     ~ClientApplication();
     ClientApplication(const ClientApplication&) = delete;
     ClientApplication(ClientApplication&&) noexcept = delete;
@@ -30,8 +62,15 @@ public:
     void run();
 
     void update();
+    // Drops render calls outside of the camera frustum or without visible sections, and splits the rest into draws
+    // of their visible sections in opaque_render_queue and translucent_render_queue. render_bounds, render_sections
+    // and render_section_ranges must match render_queue
+    void cull_render_queue();
+    // Draws the opaque quads front to back, then the far terrain and the translucent quads back to front
     void render();
     void stop();
+    void report_benchmark() const;
+    RenderStats get_render_stats() const;
 
 private:
     int width;
@@ -45,23 +84,63 @@ private:
     float dt = 0.0f;
     float frame_time = 0.0f;
     int chunk_radius = 8;
+    // heightfield terrain is drawn out to this many chunks, see FarTerrain
+    int far_radius = 64;
+    bool toggle_meshing_mode = false;
+    int benchmark_frames = 0;
+    // CPU submit time of every benchmark frame, in milliseconds
+    std::vector<float> benchmark_submit_times{};
+    size_t benchmark_draws = 0;
 
     EntityComponentSystem ECS{};
     MovementSystem* movement_system{};
     CameraSystem* camera_system{};
+    // opaque quads of each chunk, the shadow casters
     std::vector<RenderCall> render_queue{};
+    // opaque quads of each run of consecutive visible sections, see cull_render_queue
+    std::vector<RenderCall> opaque_render_queue{};
+    // translucent quads of each visible section, the sections of a chunk nearest first until render sorts them
+    std::vector<RenderCall> translucent_render_queue{};
+    DrawIndirectBuffer draw_buffer{};
+    // world space box of each render call, kept in the same order as render_queue
+    AABBBatch render_bounds{};
+    // sections of each render call reachable from the camera, see find_visible_sections
+    std::vector<uint16_t> render_sections{};
+    // quads of each section of each render call, kept in the same order as render_queue
+    std::vector<ChunkSectionRanges> render_section_ranges{};
+    // chunks of the render queue before culling, the far terrain is not drawn above them
+    std::vector<glm::ivec2> covered_chunks{};
+    std::vector<uint32_t> render_visibility{};
+    CullingStats culling_stats{};
+    // chunks inside the frustum that were culled because none of their sections are reachable
+    size_t n_occluded_chunks = 0;
+    size_t n_occluded_sections = 0;
+    // toggled in game, logs the render stats once per second
+    bool log_render_stats = false;
+    float render_stats_log_time = 0.0f;
     EventManager event_manager{};
     std::queue<Event> events{};
     ClientInterface client{};
 
-    // TODO: create shader manager
-    GLuint voxel_shader{};
+    ShaderProgram voxel_shader{ "data/shaders/voxel.vert", "data/shaders/voxel.frag" };
+    ShaderProgram hud_shader{ "data/shaders/hud.vert", "data/shaders/hud.frag" };
+    struct VoxelUniforms {
+        ShaderProgram::Uniform<glm::mat4> view;
+        ShaderProgram::Uniform<glm::mat4> projection;
+        ShaderProgram::Uniform<glm::vec3> camera_pos;
+        ShaderProgram::Uniform<float> render_radius;
+        ShaderProgram::Uniform<int> depth_map;
+        ShaderProgram::Uniform<glm::vec3> light_pos;
+        ShaderProgram::Uniform<int> texture_id;
+    } voxel_uniforms{};
 
     // TODO: Add layers
     GLuint HUD_VAO{};
     GLuint HUD_VBO{};
 
     std::unique_ptr<ShadowMap> shadow_map{};
+    std::unique_ptr<FarTerrain> far_terrain{};
+    GLuint block_texture_unit{};
 
     static void framebuffer_size_callback(GLFWwindow* window, int width, int height);
     static void error_message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "blocks/common.hpp"
+
+#include <cstddef>
+
+// Storage order policies for the blocks of a 16x16x16 ChunkSection. Each maps a position within the
+// section to an index in [0, BLOCKS_PER_SECTION). The layout is chosen at compile time with the
+// BLOCK_LAYOUT CMake option, see BlockLayout below.
+
+// z-major order: x neighbors are adjacent, y neighbors 16 apart and z neighbors 256 apart.
+struct LinearLayout {
+    static constexpr size_t index(int x, int y, int z) {
+        return CHUNK_LENGTH * CHUNK_WIDTH * z + CHUNK_LENGTH * y + x;
+    }
+};
+
+// Z-order curve: interleaves the bits of x, y and z so that every 2x2x2, 4x4x4 and 8x8x8 cube is contiguous.
+struct MortonLayout {
+    static constexpr size_t spread_bits(int value) {
+        size_t v = static_cast<size_t>(value) & 0xF;
+        v = (v | (v << 4)) & 0x0C3;
+        v = (v | (v << 2)) & 0x249;
+        return v;
+    }
+
+    static constexpr size_t index(int x, int y, int z) {
+        return spread_bits(x) | (spread_bits(y) << 1) | (spread_bits(z) << 2);
+    }
+};
+
+// 4x4x4 bricks stored in z-major order, each brick z-major internally; a brick is one contiguous run of 64 entries.
+struct BrickLayout {
+    static constexpr int BRICK_SIZE = 4;
+    static constexpr int BRICKS_PER_ROW = CHUNK_LENGTH / BRICK_SIZE;
+    static constexpr int BRICKS_PER_LAYER = BRICKS_PER_ROW * (CHUNK_WIDTH / BRICK_SIZE);
+
+    static constexpr size_t index(int x, int y, int z) {
+        size_t brick = BRICKS_PER_LAYER * (z / BRICK_SIZE) + BRICKS_PER_ROW * (y / BRICK_SIZE) + (x / BRICK_SIZE);
+        size_t within_brick = BRICK_SIZE * BRICK_SIZE * (z % BRICK_SIZE) + BRICK_SIZE * (y % BRICK_SIZE) + (x % BRICK_SIZE);
+        return brick * BRICK_SIZE * BRICK_SIZE * BRICK_SIZE + within_brick;
+    }
+};
+
+#if defined(BLOCK_LAYOUT_MORTON)
+using BlockLayout = MortonLayout;
+#define BLOCK_LAYOUT_NAME "morton"
+#elif defined(BLOCK_LAYOUT_BRICK)
+using BlockLayout = BrickLayout;
+#define BLOCK_LAYOUT_NAME "brick"
+#else
+using BlockLayout = LinearLayout;
+#define BLOCK_LAYOUT_NAME "linear"
+#endif
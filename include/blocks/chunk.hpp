@@ -1,51 +1,34 @@
 #pragma once
 
+#include "blocks/chunk_codec.hpp"
+#include "blocks/chunk_mesher.hpp"
+#include "blocks/chunk_section.hpp"
+#include "blocks/section_visibility.hpp"
 #include "blocks/common.hpp"
 #include "graphics/common.hpp"
+#include "graphics/frustum.hpp"
 #include "graphics/texture_manager.hpp"
+#include "utils/logger.hpp"
 
+#include <array>
 #include <cstddef>
 #include <optional>
 #include <unordered_map>
 #include <vector>
 
-struct Vertex {
-    int x{};                 // 5 bits
-    int y{};                 // 5 bits
-    int z{};                 // 8 bits
-    int u{};                 // 1 bit
-    int v{};                 // 1 bit
-    int texture_index{};     // 7 bits
-    int face{};              // 3 bits
-    int ambient_occlusion{}; // 2 bits
-
-    uint32_t pack_data() {
-        uint32_t data{};
-        data |= ((x & 0b11111) << 27);
-        data |= ((y & 0b11111) << 22);
-        data |= ((z & 0b111111111) << 14);
-        data |= ((u & 0b1) << 13);
-        data |= ((v & 0b1) << 12);
-        data |= ((texture_index & 0b1111111) << 5);
-        data |= ((face & 0b111) << 2);
-        data |= ((ambient_occlusion & 0b11) << 0);
-        return data;
-    }
-};
-
 struct Mesh {
-    std::vector<uint32_t> vertices{};
+    // packed QuadRecords, the opaque quads first and then the translucent ones, see ChunkMeshData
+    std::vector<uint32_t> quad_data{};
+    size_t n_opaque_quads = 0;
+    SectionQuadOffsets opaque_sections{};
+    SectionQuadOffsets translucent_sections{};
     GLuint VAO{};
     GLuint VBO{};
     GLuint shader_id{};
     GLuint texture_id{};
 };
 
-constexpr int CHUNK_LENGTH = 16;
-constexpr int CHUNK_WIDTH = 16;
-constexpr int CHUNK_HEIGHT = 256;
-constexpr int BLOCKS_PER_CHUNK = CHUNK_LENGTH * CHUNK_WIDTH * CHUNK_HEIGHT;
-constexpr int VERTICES_PER_BLOCK = 6 * 6;
+class PaddedChunk;
 
 class Chunk {
 public:
@@ -60,26 +43,65 @@ public:
     glm::ivec3 to_world_pos(glm::ivec3 chunk_pos) const;
     static glm::vec3 to_chunk_pos(glm::vec3 world_pos);
 
-    // TODO: change ordering of storage
-    size_t to_block_index(glm::vec3 world_pos) const;
-    Block& get_block(glm::ivec3 chunk_pos);
+    Block get_block(glm::ivec3 chunk_pos) const;
     Block get_block_copy(glm::ivec3 chunk_pos) const;
+    void set_block(glm::ivec3 chunk_pos, Block block);
+    const ChunkSection& get_section(int section_index) const;
+    // World space box around the non-empty sections, used for culling
+    AABB get_world_bounds() const;
 
     static std::optional<Block> get_block_from_world_pos(glm::vec3 world_pos,
                                                          const std::vector<Chunk>& loaded_chunks,
                                                          const std::unordered_map<glm::ivec2, size_t>& chunk_index_map);
+    // First non-air block hit by a ray within max_distance blocks, or with get_adjacent the block in front of the
+    // face that was hit. All chunks the ray crosses must be loaded
+    static std::optional<glm::vec3> cast_ray(glm::vec3 position,
+                                             glm::vec3 direction,
+                                             float max_distance,
+                                             bool get_adjacent,
+                                             const std::vector<Chunk>& loaded_chunks,
+                                             const std::unordered_map<glm::ivec2, size_t>& chunk_index_map);
 
     void generate_blocks_from_seed();
+    // Height of the highest solid block of a generated world column, the same for every chunk so that far terrain can
+    // be generated without the blocks, see FarTerrainData
+    static int get_ground_level(glm::ivec2 world_column, int seed);
+    // Block at height z of a generated column with the given ground level
+    static Block::Type get_generated_block(int z, int ground_level);
 
     // pass in chunk map so we can access neighboring chunks for mesh generation and lighting calculations
     void convert_to_mesh(const TextureManager& texture_manager,
                          const std::vector<Chunk>& loaded_chunks,
-                         const std::unordered_map<glm::ivec2, size_t>& chunk_index_map);
+                         const std::unordered_map<glm::ivec2, size_t>& chunk_index_map,
+                         MeshingMode meshing_mode);
+
+    // A section is hidden if it and all six of its neighboring sections are fully opaque. Sections next to a chunk
+    // at a finer level of detail are never hidden, since their faces along it are kept as a skirt, see PaddedChunk
+    bool is_section_hidden(int section_index,
+                           const std::vector<Chunk>& loaded_chunks,
+                           const std::unordered_map<glm::ivec2, size_t>& chunk_index_map) const;
 
     GLuint get_VAO() const;
-    size_t get_num_vertices() const;
+    size_t get_num_quads() const;
+    size_t get_num_opaque_quads() const;
+    size_t get_num_translucent_quads() const;
+    // Quads of each section within the opaque and the translucent quads, see ChunkMeshData
+    const SectionQuadOffsets& get_opaque_sections() const;
+    const SectionQuadOffsets& get_translucent_sections() const;
     glm::ivec2 get_chunk_coords() const;
-    const std::vector<uint32_t>& get_vertices() const;
+    int get_seed() const;
+    const std::vector<uint32_t>& get_quad_data() const;
+    // Replaces the mesh with quad records meshed elsewhere, e.g. by a MeshWorkerPool job
+    void set_quad_data(ChunkMeshData mesh_data);
+    // Replaces the translucent quads with the same quads in another order that keeps every quad in the range of its
+    // section, e.g. sorted by a TranslucencySorter
+    void set_translucent_quad_data(const std::vector<uint32_t>& quad_data);
+    // Connectivity of each section, computed with the mesh; all connected until the chunk is first meshed
+    const ChunkVisibility& get_section_visibility() const;
+    void set_section_visibility(const ChunkVisibility& visibility);
+    // Level of detail to mesh the chunk at: blocks are downsampled to cells of 2^lod blocks, see MAX_LOD
+    int get_lod() const;
+    void set_lod(int lod);
     void set_blocks(std::vector<Block> blocks);
     std::vector<Block> get_blocks() const;
 
@@ -87,16 +109,12 @@ public:
     void delete_block(glm::vec3 world_pos);
 
 private:
-    // TODO: check neighboring blocks for face culling and set block type depending on face
-    void convert_to_quads(const std::vector<Chunk>& loaded_chunks,
-                          const std::unordered_map<glm::ivec2, size_t>& chunk_index_map);
-    void generate_vertex_data(const VoxelQuad& quad, const TextureManager& texture_manager);
-
     glm::ivec2 chunk_coords;
     int seed;
-    std::vector<Block> blocks{};
-    std::vector<VoxelQuad> quads{};
+    std::array<ChunkSection, SECTIONS_PER_CHUNK> sections{};
     Mesh mesh{};
+    ChunkVisibility section_visibility{};
+    int lod = 0;
 };
 
 // Networking structs
@@ -113,7 +131,11 @@ struct ChunkRequest {
         return Packet::make(PacketType::ChunkRequest, std::move(payload));
     }
 
-    static ChunkRequest deserialize(Packet packet) {
+    // nullopt if the payload has the wrong size
+    static std::optional<ChunkRequest> deserialize(Packet packet) {
+        if (packet.payload.size() != sizeof(chunk_coords) + sizeof(seed)) {
+            return std::nullopt;
+        }
         ChunkRequest chunk_request{};
 
         std::memcpy(glm::value_ptr(chunk_request.chunk_coords), packet.payload.data(), sizeof(chunk_coords));
@@ -122,32 +144,52 @@ struct ChunkRequest {
     }
 };
 
+// Blocks are sent in the compact encoding of blocks/chunk_codec.hpp, a few KiB for generated terrain
 struct ChunkData {
     glm::ivec2 chunk_coords{};
     int seed{};
     std::vector<Block> blocks{};
 
     Packet serialize() {
-        uint32_t payload_size = sizeof(chunk_coords) + sizeof(seed) + sizeof(Block) * blocks.size();
+        std::vector<std::byte> encoded_blocks = encode_chunk_blocks(blocks);
 
-        std::vector<std::byte> payload(payload_size);
+        std::vector<std::byte> payload(sizeof(chunk_coords) + sizeof(seed) + encoded_blocks.size());
         std::memcpy(payload.data(), glm::value_ptr(chunk_coords), sizeof(chunk_coords));
         std::memcpy(payload.data() + sizeof(chunk_coords), &seed, sizeof(seed));
-        std::memcpy(payload.data() + sizeof(chunk_coords) + sizeof(seed), blocks.data(), sizeof(Block) * blocks.size());
+        std::memcpy(payload.data() + sizeof(chunk_coords) + sizeof(seed), encoded_blocks.data(), encoded_blocks.size());
 
         return Packet::make(PacketType::ChunkData, std::move(payload));
     }
 
-    static ChunkData deserialize(Packet packet) {
-        uint32_t blocks_size = (packet.header.length - sizeof(chunk_coords) - sizeof(seed)) / sizeof(Block);
-        ChunkData chunk_data{};
-        chunk_data.blocks.resize(blocks_size);
+    // Coordinates of the chunk in a ChunkData packet, nullopt if the packet is too short to hold them
+    static std::optional<glm::ivec2> read_chunk_coords(const Packet& packet) {
+        if (packet.payload.size() < sizeof(chunk_coords) + sizeof(seed)) {
+            return std::nullopt;
+        }
 
-        std::memcpy(glm::value_ptr(chunk_data.chunk_coords), packet.payload.data(), sizeof(chunk_coords));
-        std::memcpy(&chunk_data.seed, packet.payload.data() + sizeof(chunk_coords), sizeof(seed));
-        std::memcpy(chunk_data.blocks.data(), packet.payload.data() + sizeof(chunk_coords) + sizeof(seed), blocks_size * sizeof(Block));
+        glm::ivec2 coords{};
+        std::memcpy(glm::value_ptr(coords), packet.payload.data(), sizeof(coords));
+        return coords;
+    }
+
+    // nullopt if the packet is too short or its blocks cannot be decoded
+    static std::optional<ChunkData> deserialize(const Packet& packet) {
+        std::optional<glm::ivec2> coords = read_chunk_coords(packet);
+        if (!coords.has_value()) {
+            return std::nullopt;
+        }
+
+        size_t header_size = sizeof(chunk_coords) + sizeof(seed);
+        std::optional<std::vector<Block>> blocks = decode_chunk_blocks(packet.payload.data() + header_size,
+                                                                       packet.payload.size() - header_size);
+        if (!blocks.has_value()) {
+            return std::nullopt;
+        }
 
+        ChunkData chunk_data{};
+        chunk_data.chunk_coords = *coords;
+        std::memcpy(&chunk_data.seed, packet.payload.data() + sizeof(chunk_coords), sizeof(seed));
+        chunk_data.blocks = std::move(*blocks);
         return chunk_data;
     }
 };
-
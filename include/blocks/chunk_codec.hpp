@@ -0,0 +1,37 @@
+#pragma once
+
+#include "blocks/common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// Wire encoding of the blocks of a chunk, used by ChunkData. Generated terrain is a few long runs per column (stone,
+// dirt, grass, then air), so the blocks are stored as runs instead of 4 bytes each:
+//
+// byte 0: CHUNK_ENCODING_VERSION
+// byte 1: flags, CHUNK_ENCODING_LZ if the body is compressed with lz_compress
+// bytes 2-5: size of the uncompressed body, only present with CHUNK_ENCODING_LZ
+// body: every section from the bottom up:
+//     palette size n (1 byte), then the n block types of the section (1 byte each)
+//     if n > 1, the runs of every column of the section in x then y order, going up: one byte per run,
+//     palette index << 4 | (length - 1). The runs of a column always add up to SECTION_HEIGHT
+//
+// A uniform section, such as all air, takes 2 bytes.
+constexpr uint8_t CHUNK_ENCODING_VERSION = 1;
+constexpr uint8_t CHUNK_ENCODING_LZ = 1 << 0;
+
+static_assert(Block::Type::SIZE <= 16 && SECTION_HEIGHT <= 16, "Runs must fit a palette index and length in a byte");
+
+// Encodes BLOCKS_PER_CHUNK blocks in z-major order, see Chunk::get_blocks. With compress, the body is also passed
+// through lz_compress, which is kept only if it is smaller
+std::vector<std::byte> encode_chunk_blocks(const std::vector<Block>& blocks, bool compress = true);
+// Returns std::nullopt if the data is truncated, corrupt or of another version
+std::optional<std::vector<Block>> decode_chunk_blocks(const std::byte* data, size_t size);
+
+// Self-contained LZ77 compression in the style of LZ4: a sequence of literal runs, each followed by a copy of up to
+// 64 KiB back in the output. Matches may overlap their own output, so long repeats of a short pattern are cheap
+std::vector<std::byte> lz_compress(const std::vector<std::byte>& input);
+// raw_size is the size of the input given to lz_compress. Returns std::nullopt for malformed data
+std::optional<std::vector<std::byte>> lz_decompress(const std::byte* data, size_t size, size_t raw_size);
@@ -1,23 +1,58 @@
 #pragma once
 
+#include "blocks/quad_record.hpp"
+#include "graphics/buffer_allocator.hpp"
 #include "graphics/common.hpp"
 
+#include <cstddef>
 #include <cstdint>
 #include <unordered_map>
 #include <vector>
 
-struct Buffers {
-    GLuint VAO;
-    GLuint VBO;
-};
-
+// Keeps the meshes of all chunks in one shared shader storage buffer of QuadRecords, which voxel.vert reads from
+// gl_VertexID. Each chunk gets a range sized to its mesh from a BufferAllocator; the buffer is reallocated larger
+// when no free range fits. Meshes are drawn with a static index buffer repeating QUAD_INDICES and a base vertex of
+// 4 times the first quad of the chunk. The VAO has no attributes and only holds the index buffer.
 class ChunkGPUHandler {
 public:
+    // bytes per quad, since the ranges of the buffer and get_stats() count quads
+    static constexpr size_t QUAD_SIZE = QUAD_RECORD_WORDS * sizeof(uint32_t);
+    // in quads, 16 MiB
+    static constexpr size_t INITIAL_CAPACITY = 2 * 1024 * 1024;
+    // allocations are rounded up to this many quads so that freed ranges are easier to reuse
+    static constexpr size_t ALLOCATION_GRANULARITY = 64;
+    // must match the ChunkQuads binding in voxel.vert and depth.vert
+    static constexpr GLuint QUAD_BUFFER_BINDING = 1;
+    // quads covered by the index buffer before it has to grow
+    static constexpr size_t INITIAL_INDEXED_QUADS = 64 * 1024;
+
+    ChunkGPUHandler() = default;
+    ~ChunkGPUHandler();
+
+    ChunkGPUHandler(const ChunkGPUHandler&) = delete;
+    ChunkGPUHandler& operator=(const ChunkGPUHandler&) = delete;
+    ChunkGPUHandler(ChunkGPUHandler&&) = delete;
+    ChunkGPUHandler& operator=(ChunkGPUHandler&&) = delete;
+
     void allocate_chunk(glm::ivec2 chunk_coords);
     void deallocate_chunk(glm::ivec2 chunk_coords);
-    void send_mesh_to_gpu(glm::ivec2 chunk_coords, const std::vector<uint32_t>& vertices);
+    void send_mesh_to_gpu(glm::ivec2 chunk_coords, const std::vector<uint32_t>& quad_data);
+    // Overwrites part of the uploaded mesh of a chunk, starting at its first_quad-th quad, without reallocating
+    void update_quads(glm::ivec2 chunk_coords, size_t first_quad, const std::vector<uint32_t>& quad_data);
     GLuint get_chunk_VAO(glm::ivec2 chunk_coords) const;
+    // Index of the first quad of the chunk's mesh in the shared buffer
+    size_t get_chunk_first_quad(glm::ivec2 chunk_coords) const;
+    BufferAllocatorStats get_stats() const;
 
 private:
-    std::unordered_map<glm::ivec2, Buffers> chunk_buffers_map{};
+    void create_buffer();
+    void grow_buffer(size_t min_capacity);
+    void reserve_indices(size_t n_quads);
+
+    GLuint VAO{};
+    GLuint SSBO{};
+    GLuint EBO{};
+    size_t n_indexed_quads = 0;
+    BufferAllocator allocator{ 0 };
+    std::unordered_map<glm::ivec2, BufferRange> chunk_ranges{};
 };
@@ -2,13 +2,38 @@
 
 #include "blocks/chunk.hpp"
 #include "blocks/chunk_gpu_handler.hpp"
+#include "blocks/mesh_worker_pool.hpp"
+#include "blocks/translucency_sorter.hpp"
+#include "graphics/frustum.hpp"
 #include "networking/client.hpp"
 #include "networking/packet.hpp"
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
 
+// Chunks at least LOD_DISTANCES[i] chunks away from the camera are meshed at level of detail i + 1
+constexpr std::array<int, MAX_LOD> LOD_DISTANCES = { 8, 16 };
+
+// Counters of the remesh scheduler since startup
+struct MeshStats {
+    // remesh requests for loaded chunks
+    size_t requested = 0;
+    // requests for a chunk that was already waiting to be remeshed
+    size_t coalesced = 0;
+    // jobs handed to the worker pool
+    size_t submitted = 0;
+    // queued jobs dropped before a worker started them
+    size_t cancelled = 0;
+    // meshes finished by a worker but discarded because the chunk changed or was unloaded in the meantime
+    size_t wasted = 0;
+    size_t uploaded = 0;
+};
+
 class ChunkManager {
 public:
     ChunkManager(int seed, int chunk_radius);
@@ -17,17 +42,40 @@ public:
     void update(glm::vec3 player_pos);
 
     void request_all_chunks(ClientInterface& client);
+    // Generates the requested chunks locally the way the server does, for running without a server
+    void generate_requested_chunks();
     void receive_chunk_data(Packet packet);
 
     void load_chunks(int num_chunks);
     void load_all_chunks();
     void unload_chunks(int num_chunks);
 
+    // Camera used to order remeshing: chunks in the view frustum first, then the nearest ones. Also finds the
+    // sections visible from the camera, see find_visible_sections, remeshes chunks whose level of detail changed
+    // along with their neighbors, and re-sorts the translucent quads of every chunk when the camera enters another
+    // block
+    void set_view(glm::vec3 camera_position, const glm::mat4& view_projection);
+    // Mask of the sections of the chunk reachable from the camera at the last set_view, all set for chunks loaded
+    // since
+    uint16_t get_visible_sections(glm::ivec2 chunk_coords) const;
+
+    // Uploads finished meshes and translucent quad orders, then snapshots the num_chunks most important dirty chunks
+    // and meshes them on the worker pool
     void mesh_chunks(int num_chunks, TextureManager& texture_manager);
+    // Meshes every dirty chunk and waits for all of them to be uploaded
     void mesh_all_chunks(TextureManager& texture_manager);
+    const MeshStats& get_mesh_stats() const;
+    // World space columns of the chunks whose mesh was uploaded or removed since the last call, so that cached
+    // renderings of them can be invalidated
+    std::vector<AABB> take_changed_mesh_bounds();
+
+    // Switches the mesher used for all chunks and queues every loaded chunk to be remeshed
+    void set_meshing_mode(MeshingMode mode);
+    MeshingMode get_meshing_mode() const;
 
     std::vector<Chunk>& get_chunks();
     GLuint get_chunk_VAO(glm::ivec2 chunk_coords) const;
+    size_t get_chunk_first_quad(glm::ivec2 chunk_coords) const;
 
     // Set get_adjacent to true to get the adjacent block on the face of the hit block: used for placing blocks
     std::optional<glm::vec3> cast_ray(glm::vec3 position, glm::vec3 direction, bool get_adjacent);
@@ -35,8 +83,20 @@ public:
     void add_event(Event event);
 
 private:
+    // Invalidates any in-flight mesh of the chunk and marks it dirty; does nothing for unloaded chunks
+    void remesh_chunk(glm::ivec2 chunk_pos);
+    void invalidate_mesh(glm::ivec2 chunk_pos);
+    int get_lod(glm::ivec2 chunk_pos) const;
+    void update_lods();
+    std::vector<glm::ivec2> take_dirty_chunks(size_t max_chunks);
+    void submit_mesh_job(glm::ivec2 chunk_pos, const TextureManager& texture_manager);
+    int upload_mesh_results();
+    void submit_sort_job(glm::ivec2 chunk_pos);
+    void upload_sort_results();
+
     int seed;
     int chunk_radius;
+    MeshingMode meshing_mode = MeshingMode::Binary;
 
     std::vector<Chunk> loaded_chunks{};
     std::unordered_map<glm::ivec2, size_t> chunk_index_map{};
@@ -47,9 +107,29 @@ private:
     std::queue<glm::ivec2> request_chunk_queue{};
     std::queue<ChunkData> received_chunk_queue{};
     std::queue<glm::ivec2> unload_chunk_queue{};
-    std::queue<glm::ivec2> mesh_chunk_queue{};
+    // loaded chunks waiting to be remeshed, repeated requests for the same chunk are merged
+    std::unordered_set<glm::ivec2> dirty_chunks{};
 
     std::queue<Event> events{};
 
     ChunkGPUHandler chunk_gpu_handler{};
+
+    glm::vec3 camera_position{};
+    Frustum view_frustum{};
+    // indexed like loaded_chunks
+    std::vector<uint16_t> visible_sections{};
+    MeshStats mesh_stats{};
+    std::vector<AABB> changed_mesh_bounds{};
+
+    // version of the latest mesh job of each chunk with a job in flight; results with any other version are stale
+    std::unordered_map<glm::ivec2, uint64_t> mesh_versions{};
+    uint64_t next_mesh_version = 1;
+    // same for the translucent quad order of each chunk
+    std::unordered_map<glm::ivec2, uint64_t> sort_versions{};
+    uint64_t next_sort_version = 1;
+    // block of the camera when the translucent quads were last sorted
+    std::optional<glm::ivec3> sort_camera_block{};
+    TranslucencySorter translucency_sorter{};
+    // declared last so the workers are joined before anything they could reference is destroyed
+    MeshWorkerPool mesh_worker_pool{ MeshWorkerPool::default_num_threads() };
 };
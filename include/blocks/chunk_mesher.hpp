@@ -0,0 +1,62 @@
+#pragma once
+
+#include "blocks/common.hpp"
+#include "blocks/quad_record.hpp"
+#include "graphics/texture_manager.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class PaddedChunk;
+
+// Meshes are lists of packed QuadRecords. Every quad is drawn as 4 vertices and two triangles with the same indices
+// relative to its first vertex, so one static index buffer serves all chunks.
+constexpr int VERTICES_PER_QUAD = 4;
+constexpr int INDICES_PER_QUAD = 6;
+constexpr std::array<uint32_t, INDICES_PER_QUAD> QUAD_INDICES = { 0, 1, 2, 2, 3, 0 };
+
+enum class MeshingMode {
+    // one quad per visible block face
+    PerFace,
+    // coplanar faces with the same texture and ambient occlusion are merged into larger quads within each section
+    Greedy,
+    // face culling and greedy merging on row bitmasks, merged quads do not cross sections
+    Binary,
+};
+
+// Where the quads of each section start, counted in quads from the start of one kind of quads: the quads of
+// section i are [offsets[i], offsets[i + 1]), and offsets[SECTIONS_PER_CHUNK] is the number of quads of that kind
+using SectionQuadOffsets = std::array<uint32_t, SECTIONS_PER_CHUNK + 1>;
+
+// Quad records of one chunk: the opaque faces first, then the translucent ones (glass, water), so that each kind is
+// a contiguous range drawn in its own pass. Within each kind the quads are grouped by the section of their block,
+// from the bottom up, so that only the sections visible from the camera are drawn
+struct ChunkMeshData {
+    std::vector<uint32_t> quad_data{};
+    size_t n_opaque_quads = 0;
+    SectionQuadOffsets opaque_sections{};
+    SectionQuadOffsets translucent_sections{};
+};
+
+// Turns a PaddedChunk snapshot into packed quad records. Meshing only reads the snapshot and the texture manager,
+// so a mesher per thread can run concurrently; the quad buffer is kept between calls to avoid reallocating.
+class ChunkMesher {
+public:
+    ChunkMeshData mesh(const PaddedChunk& padded_chunk,
+                       const TextureManager& texture_manager,
+                       MeshingMode meshing_mode);
+    // Number of quads mesh would produce, without needing textures or a GL context
+    size_t count_quads(const PaddedChunk& padded_chunk, MeshingMode meshing_mode);
+
+private:
+    void build_quads(const PaddedChunk& padded_chunk, MeshingMode meshing_mode);
+    void convert_to_quads(const PaddedChunk& padded_chunk);
+    void merge_quads();
+    void convert_to_quads_binary(const PaddedChunk& padded_chunk);
+    void generate_quad_record(const VoxelQuad& quad, const TextureManager& texture_manager);
+
+    std::vector<VoxelQuad> quads{};
+    std::vector<uint32_t> mesh_data{};
+};
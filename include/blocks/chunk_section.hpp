@@ -0,0 +1,62 @@
+#pragma once
+
+#include "blocks/block_layout.hpp"
+#include "blocks/common.hpp"
+#include "blocks/palette_storage.hpp"
+
+// A 16x16x16 vertical slice of a chunk, with blocks stored in the order given by the Layout policy.
+// Occupancy counters are kept up to date on every write so that all-air and all-opaque sections can be
+// recognized in O(1) and skipped by meshing, raycasting and serialization.
+template <typename Layout>
+class BasicChunkSection {
+public:
+    // section_pos.z is relative to the bottom of the section
+    Block get_block(glm::ivec3 section_pos) const {
+        return blocks.get(Layout::index(section_pos.x, section_pos.y, section_pos.z));
+    }
+
+    void set_block(glm::ivec3 section_pos, Block block) {
+        size_t index = Layout::index(section_pos.x, section_pos.y, section_pos.z);
+        Block old_block = blocks.get(index);
+        if (old_block.type == block.type) {
+            return;
+        }
+
+        non_air_count += (block.type != Block::Type::AIR) - (old_block.type != Block::Type::AIR);
+        opaque_count += !Block::is_transparent(block) - !Block::is_transparent(old_block);
+        blocks.set(index, block);
+    }
+
+    void fill(Block block) {
+        blocks.fill(block);
+        non_air_count = block.type != Block::Type::AIR ? BLOCKS_PER_SECTION : 0;
+        opaque_count = !Block::is_transparent(block) ? BLOCKS_PER_SECTION : 0;
+    }
+
+    const PaletteStorage& get_storage() const {
+        return blocks;
+    }
+
+    int get_non_air_count() const {
+        return non_air_count;
+    }
+
+    int get_opaque_count() const {
+        return opaque_count;
+    }
+
+    bool is_empty() const {
+        return non_air_count == 0;
+    }
+
+    bool is_opaque() const {
+        return opaque_count == BLOCKS_PER_SECTION;
+    }
+
+private:
+    PaletteStorage blocks{ BLOCKS_PER_SECTION };
+    int non_air_count = 0;
+    int opaque_count = 0;
+};
+
+using ChunkSection = BasicChunkSection<BlockLayout>;
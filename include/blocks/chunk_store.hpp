@@ -0,0 +1,73 @@
+#pragma once
+
+#include "blocks/chunk.hpp"
+#include "graphics/common.hpp"
+#include "networking/packet.hpp"
+
+#include <cstddef>
+#include <list>
+#include <optional>
+#include <unordered_map>
+
+// Counters of a ChunkStore since startup
+struct ChunkStoreStats {
+    // requests answered from the store
+    size_t hits = 0;
+    // requests for chunks that were not stored
+    size_t misses = 0;
+    // chunks dropped to stay within the memory budget
+    size_t evictions = 0;
+};
+
+// Generated chunks kept by the server, keyed by chunk coordinates and seed, along with their encoded ChunkData
+// packet, so that a repeated request is a hash lookup and a send. Blocks stay in the palette compressed sections of
+// the Chunk. Once the entries use more than the memory budget, the least recently requested ones are evicted.
+// Not thread safe, see ChunkService.
+class ChunkStore {
+public:
+    // 64 MiB holds about 8,000 generated chunks
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+
+    struct Key {
+        glm::ivec2 chunk_coords;
+        int seed;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    explicit ChunkStore(size_t memory_budget = DEFAULT_MEMORY_BUDGET);
+
+    // ChunkData packet of a stored chunk, or std::nullopt. Counts as a request
+    std::optional<Packet> find_packet(glm::ivec2 chunk_coords, int seed);
+    // The stored chunk, or nullptr. Does not count as a request
+    const Chunk* find_chunk(glm::ivec2 chunk_coords, int seed) const;
+    // Stores a generated chunk and its ChunkData packet, replacing any stored entry for the same key
+    void insert(Chunk chunk, Packet packet);
+
+    const ChunkStoreStats& get_stats() const;
+    size_t size() const;
+    // Approximate bytes used by the stored chunks and packets
+    size_t get_memory_usage() const;
+    size_t get_memory_budget() const;
+
+private:
+    struct Entry {
+        Key key;
+        Chunk chunk;
+        Packet packet;
+        size_t memory_usage;
+    };
+
+    void evict();
+
+    size_t memory_budget;
+    size_t memory_usage = 0;
+    // most recently requested first
+    std::list<Entry> entries{};
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> entry_map{};
+    ChunkStoreStats stats{};
+};
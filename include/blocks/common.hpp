@@ -2,6 +2,17 @@
 
 #include "graphics/common.hpp"
 
+constexpr int CHUNK_LENGTH = 16;
+constexpr int CHUNK_WIDTH = 16;
+constexpr int CHUNK_HEIGHT = 256;
+constexpr int BLOCKS_PER_CHUNK = CHUNK_LENGTH * CHUNK_WIDTH * CHUNK_HEIGHT;
+
+constexpr int SECTION_HEIGHT = 16;
+constexpr int SECTIONS_PER_CHUNK = CHUNK_HEIGHT / SECTION_HEIGHT;
+constexpr int BLOCKS_PER_SECTION = CHUNK_LENGTH * CHUNK_WIDTH * SECTION_HEIGHT;
+// Distant chunks are meshed from blocks downsampled to cells of 2^lod blocks, up to 4x4x4
+constexpr int MAX_LOD = 2;
+
 struct Block {
     enum Type : int {
         AIR = 0,
@@ -16,7 +27,7 @@ struct Block {
     static bool is_transparent(Block block);
 };
 
-// Represents a face of a voxel, always has size 1x1.
+// Represents a face of a voxel, or a rectangle of coplanar faces after greedy meshing.
 struct VoxelQuad {
     enum Face : int {
         TOP = 0,
@@ -29,6 +40,8 @@ struct VoxelQuad {
     glm::ivec3 chunk_pos{};
     Block::Type block_type{};
     glm::ivec4 ao_state{};
+    // extent in blocks along the two axes of the face plane, see face_plane_axes in chunk.cpp
+    glm::ivec2 size{ 1, 1 };
 
     VoxelQuad(VoxelQuad::Face face, int x, int y, int z, Block::Type block_type, glm::ivec4 ao_state);
 };
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "blocks/common.hpp"
+#include "graphics/common.hpp"
+#include "graphics/draw_indirect_buffer.hpp"
+#include "graphics/shader_program.hpp"
+#include "graphics/texture_manager.hpp"
+#include "networking/client.hpp"
+#include "networking/packet.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// A far terrain tile covers FAR_TILE_CHUNKS x FAR_TILE_CHUNKS chunk columns
+constexpr int FAR_TILE_CHUNKS = 4;
+// blocks between two heightmap samples
+constexpr int FAR_SAMPLE_SPACING = 4;
+// samples along each side of a tile, the last row and column are shared with the next tiles so that they meet
+constexpr int FAR_TILE_SAMPLES = FAR_TILE_CHUNKS * CHUNK_LENGTH / FAR_SAMPLE_SPACING + 1;
+constexpr int SAMPLES_PER_FAR_TILE = FAR_TILE_SAMPLES * FAR_TILE_SAMPLES;
+
+static_assert(CHUNK_LENGTH == CHUNK_WIDTH, "Far terrain tiles are square");
+static_assert(CHUNK_HEIGHT <= 256, "Far terrain heights must fit in a uint8_t");
+
+// Networking structs
+
+struct FarTerrainRequest {
+    glm::ivec2 tile_coords{};
+    int seed{};
+
+    Packet serialize() {
+        std::vector<std::byte> payload(sizeof(tile_coords) + sizeof(seed));
+        std::memcpy(payload.data(), glm::value_ptr(tile_coords), sizeof(tile_coords));
+        std::memcpy(payload.data() + sizeof(tile_coords), &seed, sizeof(seed));
+
+        return Packet::make(PacketType::FarTerrainRequest, std::move(payload));
+    }
+
+    // nullopt if the payload has the wrong size
+    static std::optional<FarTerrainRequest> deserialize(Packet packet) {
+        if (packet.payload.size() != sizeof(tile_coords) + sizeof(seed)) {
+            return std::nullopt;
+        }
+        FarTerrainRequest request{};
+
+        std::memcpy(glm::value_ptr(request.tile_coords), packet.payload.data(), sizeof(tile_coords));
+        std::memcpy(&request.seed, packet.payload.data() + sizeof(tile_coords), sizeof(seed));
+        return request;
+    }
+};
+
+// Ground level and top block of the block column under every sample of a tile, row by row with x fastest. Sample
+// (i, j) of tile (x, y) is the column at FAR_SAMPLE_SPACING * (i, j) + FAR_TILE_CHUNKS * CHUNK_LENGTH * (x, y)
+struct FarTerrainData {
+    glm::ivec2 tile_coords{};
+    int seed{};
+    std::vector<uint8_t> heights{};
+    std::vector<uint8_t> top_blocks{};
+
+    // Samples the noise of Chunk::generate_blocks_from_seed, without generating any blocks
+    static FarTerrainData generate(glm::ivec2 tile_coords, int seed);
+
+    Packet serialize() {
+        std::vector<std::byte> payload(sizeof(tile_coords) + sizeof(seed) + 2 * SAMPLES_PER_FAR_TILE);
+        std::byte* data = payload.data();
+        std::memcpy(data, glm::value_ptr(tile_coords), sizeof(tile_coords));
+        std::memcpy(data + sizeof(tile_coords), &seed, sizeof(seed));
+        std::memcpy(data + sizeof(tile_coords) + sizeof(seed), heights.data(), SAMPLES_PER_FAR_TILE);
+        std::memcpy(data + sizeof(tile_coords) + sizeof(seed) + SAMPLES_PER_FAR_TILE, top_blocks.data(), SAMPLES_PER_FAR_TILE);
+
+        return Packet::make(PacketType::FarTerrainData, std::move(payload));
+    }
+
+    // nullopt if the payload has the wrong size. The top blocks are not checked, see FarTerrain::load_tiles
+    static std::optional<FarTerrainData> deserialize(Packet packet) {
+        if (packet.payload.size() != sizeof(tile_coords) + sizeof(seed) + 2 * SAMPLES_PER_FAR_TILE) {
+            return std::nullopt;
+        }
+        FarTerrainData tile{};
+        tile.heights.resize(SAMPLES_PER_FAR_TILE);
+        tile.top_blocks.resize(SAMPLES_PER_FAR_TILE);
+
+        const std::byte* data = packet.payload.data();
+        std::memcpy(glm::value_ptr(tile.tile_coords), data, sizeof(tile_coords));
+        std::memcpy(&tile.seed, data + sizeof(tile_coords), sizeof(seed));
+        std::memcpy(tile.heights.data(), data + sizeof(tile_coords) + sizeof(seed), SAMPLES_PER_FAR_TILE);
+        std::memcpy(tile.top_blocks.data(), data + sizeof(tile_coords) + sizeof(seed) + SAMPLES_PER_FAR_TILE, SAMPLES_PER_FAR_TILE);
+
+        return tile;
+    }
+};
+
+// Heightfield terrain for the ring between the loaded chunks and far_radius chunks from the player. The server sends
+// a FarTerrainData heightmap per tile instead of whole chunks. Each tile takes a slot of SAMPLES_PER_FAR_TILE packed
+// samples in one shared storage buffer, which far_terrain.vert expands into a grid of vertices, and all tiles are
+// drawn with one multi-draw. Tiles are cut out in the fragment shader above every chunk with a mesh, so the real
+// chunks replace the far terrain as they load.
+class FarTerrain {
+public:
+    // must match the FarSamples binding in far_terrain.vert
+    static constexpr GLuint SAMPLE_BUFFER_BINDING = 3;
+
+    FarTerrain(int seed, int chunk_radius, int far_radius);
+    ~FarTerrain();
+
+    FarTerrain(const FarTerrain&) = delete;
+    FarTerrain& operator=(const FarTerrain&) = delete;
+    FarTerrain(FarTerrain&&) = delete;
+    FarTerrain& operator=(FarTerrain&&) = delete;
+
+    // Given the current player position, determine which tiles to request and unload. Only rescans when the
+    // player enters another chunk
+    void update(glm::vec3 player_pos);
+
+    void request_all_tiles(ClientInterface& client);
+    // Generates the requested tiles locally the way the server does, for running without a server
+    void generate_requested_tiles();
+    // Drops malformed packets
+    void receive_tile_data(Packet packet);
+    // Uploads up to num_tiles received tiles, dropping those that left the ring while in flight and those with
+    // unknown top blocks, which are requested again on the next rescan
+    void load_tiles(int num_tiles, const TextureManager& texture_manager);
+
+    // Chunks drawn by the ChunkManager, the far terrain is not drawn above them
+    void set_covered_chunks(const std::vector<glm::ivec2>& chunk_coords);
+    // Draws the loaded tiles inside the view frustum with the far terrain program
+    void draw(const glm::mat4& view, const glm::mat4& projection, glm::vec3 camera_pos, float render_radius,
+              glm::vec3 light_pos, GLuint texture_unit);
+    // Rebuilds the far terrain program from its files, keeping the current one on failure
+    bool reload_shader();
+
+    size_t get_num_tiles() const;
+    // Bytes of GPU memory holding the samples of the loaded tiles
+    size_t get_memory_usage() const;
+
+private:
+    struct TileSlot {
+        size_t slot;
+        // height range of the tile's surface, for culling
+        float min_z;
+        float max_z;
+    };
+
+    bool is_tile_needed(glm::ivec2 tile_coords, int margin) const;
+    void unload_tile(glm::ivec2 tile_coords);
+
+    int seed;
+    int chunk_radius;
+    int far_radius;
+    // chunk of the player at the last update
+    glm::ivec2 center_chunk{};
+    bool scanned = false;
+
+    std::unordered_set<glm::ivec2> request_tile_queue_set{};
+    std::queue<glm::ivec2> request_tile_queue{};
+    std::queue<FarTerrainData> received_tile_queue{};
+
+    std::unordered_map<glm::ivec2, TileSlot> loaded_tiles{};
+    std::vector<size_t> free_slots{};
+    // tiles the sample buffer has room for, enough for every tile the ring can keep
+    size_t max_tiles = 0;
+
+    GLuint VAO{};
+    GLuint EBO{};
+    GLuint sample_buffer{};
+    GLuint covered_texture{};
+    GLuint covered_unit{};
+    // side of the covered chunk mask, chunk (x, y) is stored at (x & (size - 1), y & (size - 1))
+    int covered_size = 0;
+    std::vector<uint8_t> covered_chunks{};
+
+    DrawIndirectBuffer draw_buffer{};
+    ShaderProgram shader{ "data/shaders/far_terrain.vert", "data/shaders/far_terrain.frag" };
+    struct FarTerrainUniforms {
+        ShaderProgram::Uniform<glm::mat4> view;
+        ShaderProgram::Uniform<glm::mat4> projection;
+        ShaderProgram::Uniform<glm::vec3> camera_pos;
+        ShaderProgram::Uniform<float> render_radius;
+        ShaderProgram::Uniform<glm::vec3> light_pos;
+        ShaderProgram::Uniform<int> texture_id;
+        ShaderProgram::Uniform<int> covered_chunks;
+    } uniforms{};
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "blocks/chunk_mesher.hpp"
+#include "blocks/padded_chunk.hpp"
+#include "blocks/section_visibility.hpp"
+#include "graphics/common.hpp"
+#include "graphics/texture_manager.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct MeshJob {
+    glm::ivec2 chunk_coords{};
+    // unique per job, used by the owner to recognize results that were invalidated while meshing
+    uint64_t version{};
+    PaddedChunk padded_chunk;
+    const TextureManager* texture_manager{};
+    MeshingMode meshing_mode{};
+};
+
+struct MeshResult {
+    glm::ivec2 chunk_coords{};
+    uint64_t version{};
+    ChunkMeshData mesh_data{};
+    ChunkVisibility section_visibility{};
+};
+
+// Meshes chunk snapshots on a fixed number of worker threads. Jobs own their PaddedChunk, so workers never
+// touch loaded chunks; finished quad data is collected with take_results on the thread that owns the GL
+// context and uploaded there.
+class MeshWorkerPool {
+public:
+    explicit MeshWorkerPool(int num_threads);
+    ~MeshWorkerPool();
+
+    MeshWorkerPool(const MeshWorkerPool&) = delete;
+    MeshWorkerPool& operator=(const MeshWorkerPool&) = delete;
+    MeshWorkerPool(MeshWorkerPool&&) = delete;
+    MeshWorkerPool& operator=(MeshWorkerPool&&) = delete;
+
+    // One thread is left for the render thread
+    static int default_num_threads();
+
+    void submit(MeshJob job);
+    // Drops queued jobs of a chunk. A job that is already being meshed still finishes, its result has to be
+    // discarded by version. Returns the number of jobs dropped
+    int cancel(glm::ivec2 chunk_coords);
+    std::vector<MeshResult> take_results();
+    // Blocks until every submitted job has finished
+    void wait_idle();
+
+    int get_num_threads() const;
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread> workers{};
+    std::deque<MeshJob> jobs{};
+    std::vector<MeshResult> results{};
+    int n_active_jobs = 0;
+    bool stopping = false;
+
+    std::mutex mutex{};
+    std::condition_variable job_available{};
+    std::condition_variable jobs_finished{};
+};
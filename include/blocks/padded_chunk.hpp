@@ -0,0 +1,87 @@
+#pragma once
+
+#include "blocks/common.hpp"
+#include "graphics/common.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Chunk;
+
+// Meshing input: a copy of a chunk's blocks plus a one block border taken from its 8 neighbors, stored in a
+// contiguous 18x18x258 array so that face culling and ambient occlusion only need array indexing.
+// Blocks in unloaded neighbors and above/below the world are stored as air, matching how the mesher
+// treated missing blocks before.
+// Chunks with a level of detail above 0 are downsampled: each cell of 2^lod blocks is filled with its most common
+// block if at least half of it is not air. The border holds the neighbors as they are meshed, downsampled at their
+// own level. Only the border facing a finer neighbor is left as air: the coarser chunk keeps its faces along it as
+// a skirt, which covers the gaps where the two surfaces do not line up.
+class PaddedChunk {
+public:
+    static constexpr int LENGTH = CHUNK_LENGTH + 2;
+    static constexpr int WIDTH = CHUNK_WIDTH + 2;
+    static constexpr int HEIGHT = CHUNK_HEIGHT + 2;
+
+    PaddedChunk(const Chunk& chunk,
+                const std::vector<Chunk>& loaded_chunks,
+                const std::unordered_map<glm::ivec2, size_t>& chunk_index_map);
+
+    // chunk_pos may be up to one block outside of the chunk in every direction
+    Block get_block(glm::ivec3 chunk_pos) const;
+    // Bit x + 1 of a row is set if the block at (x, y, z) is opaque, or not air for solid rows. x, y and z
+    // may be up to one block outside of the chunk, like for get_block
+    uint32_t get_opaque_row(int y, int z) const;
+    uint32_t get_solid_row(int y, int z) const;
+    // True if the section has nothing to mesh: it is all air or fully enclosed by opaque sections
+    bool is_section_skipped(int section_index) const;
+    bool is_section_empty(int section_index) const;
+    bool is_section_opaque(int section_index) const;
+    glm::ivec2 get_chunk_coords() const;
+    int get_lod() const;
+
+private:
+    static size_t to_index(glm::ivec3 chunk_pos);
+    static size_t to_row_index(int y, int z);
+    void copy_blocks(const Chunk& chunk, glm::ivec2 min_pos, glm::ivec2 max_pos, glm::ivec2 offset);
+    void copy_downsampled_blocks(const Chunk& chunk,
+                                 glm::ivec2 min_pos,
+                                 glm::ivec2 max_pos,
+                                 glm::ivec2 offset,
+                                 int cell_size);
+    void downsample(int cell_size);
+    void build_rows();
+
+    glm::ivec2 chunk_coords;
+    int lod;
+    // Block::Type fits in a byte, which keeps the whole array around 80 KiB
+    std::vector<uint8_t> blocks;
+    // one bitmask per x row, used by the binary mesher to cull faces a whole row at a time
+    std::vector<uint32_t> opaque_rows;
+    std::vector<uint32_t> solid_rows;
+    std::array<bool, SECTIONS_PER_CHUNK> skipped_sections{};
+    std::array<bool, SECTIONS_PER_CHUNK> empty_sections{};
+    std::array<bool, SECTIONS_PER_CHUNK> opaque_sections{};
+};
+
+inline size_t PaddedChunk::to_index(glm::ivec3 chunk_pos) {
+    return LENGTH * WIDTH * (chunk_pos.z + 1) + LENGTH * (chunk_pos.y + 1) + (chunk_pos.x + 1);
+}
+
+inline size_t PaddedChunk::to_row_index(int y, int z) {
+    return WIDTH * (z + 1) + (y + 1);
+}
+
+inline uint32_t PaddedChunk::get_opaque_row(int y, int z) const {
+    return opaque_rows[to_row_index(y, z)];
+}
+
+inline uint32_t PaddedChunk::get_solid_row(int y, int z) const {
+    return solid_rows[to_row_index(y, z)];
+}
+
+inline Block PaddedChunk::get_block(glm::ivec3 chunk_pos) const {
+    return { static_cast<Block::Type>(blocks[to_index(chunk_pos)]) };
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "blocks/common.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-size block array stored as bit-packed indices into a palette of the block types present.
+// Indices are 0, 1, 2, 4, 8 or 16 bits wide and widen automatically when a new block type is added,
+// so a chunk of only air needs no index storage and typical terrain needs 2 bits per block.
+// Widths are powers of two so that an index never straddles two 64-bit words.
+// Block types that no block uses anymore stay in the palette until it would have to grow: a new type is then first
+// given the slot of an unused one, and the indices only widen if every entry is still in use.
+class PaletteStorage {
+public:
+    explicit PaletteStorage(size_t size, Block block = { Block::Type::AIR });
+
+    Block get(size_t index) const;
+    void set(size_t index, Block block);
+    void fill(Block block);
+
+    size_t size() const;
+    int get_bits_per_index() const;
+    const std::vector<Block::Type>& get_palette() const;
+    // Approximate number of heap bytes used by the palette and indices
+    size_t memory_usage() const;
+
+private:
+    uint32_t get_palette_index(size_t index) const;
+    int get_or_add_palette_index(Block::Type type);
+    std::vector<uint32_t> compact_palette();
+    void repack(int new_bits_per_index, const std::vector<uint32_t>& remap = {});
+
+    size_t n_blocks;
+    int bits_per_index = 0;
+    std::vector<Block::Type> palette{};
+    std::vector<uint64_t> indices{};
+};
+
+inline Block PaletteStorage::get(size_t index) const {
+    return { palette[get_palette_index(index)] };
+}
+
+inline uint32_t PaletteStorage::get_palette_index(size_t index) const {
+    if (bits_per_index == 0) {
+        return 0;
+    }
+
+    size_t bit = index * bits_per_index;
+    uint64_t mask = (uint64_t{1} << bits_per_index) - 1;
+    return static_cast<uint32_t>((indices[bit >> 6] >> (bit & 63)) & mask);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "graphics/common.hpp"
+
+#include <array>
+#include <cstdint>
+
+constexpr int QUAD_RECORD_WORDS = 2;
+
+// Everything voxel.vert needs to draw one quad, packed into two words of the chunk quad storage buffer. The vertex
+// shader expands each record into 4 vertices from gl_VertexID, see QUAD_INDICES. Texture coordinates are not
+// stored: they are derived from the position and face, which lets a merged quad repeat its texture once per block.
+//
+// word 0: x (4 bits) | y (4 bits) << 4 | z (8 bits) << 8 | face (3 bits) << 16 | texture index (7 bits) << 19
+// word 1: ambient occlusion of each corner (2 bits each) | size.x - 1 (8 bits) << 8 | size.y - 1 (8 bits) << 16
+struct QuadRecord {
+    // block position of the quad origin within the chunk
+    glm::ivec3 chunk_pos{};
+    int face{};
+    int texture_index{};
+    // in VoxelQuad::ao_state corner order
+    glm::ivec4 ao_state{};
+    glm::ivec2 size{ 1, 1 };
+
+    bool operator==(const QuadRecord& other) const = default;
+
+    std::array<uint32_t, QUAD_RECORD_WORDS> pack() const {
+        uint32_t position_data{};
+        position_data |= ((chunk_pos.x & 0b1111) << 0);
+        position_data |= ((chunk_pos.y & 0b1111) << 4);
+        position_data |= ((chunk_pos.z & 0b11111111) << 8);
+        position_data |= ((face & 0b111) << 16);
+        position_data |= ((texture_index & 0b1111111) << 19);
+
+        uint32_t shape_data{};
+        for (int i = 0; i < 4; i++) {
+            shape_data |= ((ao_state[i] & 0b11) << (2 * i));
+        }
+        shape_data |= (((size.x - 1) & 0b11111111) << 8);
+        shape_data |= (((size.y - 1) & 0b11111111) << 16);
+
+        return { position_data, shape_data };
+    }
+
+    static QuadRecord unpack(std::array<uint32_t, QUAD_RECORD_WORDS> data) {
+        QuadRecord record{};
+        record.chunk_pos = { (data[0] >> 0) & 0b1111, (data[0] >> 4) & 0b1111, (data[0] >> 8) & 0b11111111 };
+        record.face = (data[0] >> 16) & 0b111;
+        record.texture_index = (data[0] >> 19) & 0b1111111;
+
+        for (int i = 0; i < 4; i++) {
+            record.ao_state[i] = (data[1] >> (2 * i)) & 0b11;
+        }
+        record.size = { ((data[1] >> 8) & 0b11111111) + 1, ((data[1] >> 16) & 0b11111111) + 1 };
+
+        return record;
+    }
+};
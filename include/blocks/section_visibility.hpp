@@ -0,0 +1,44 @@
+#pragma once
+
+#include "blocks/common.hpp"
+#include "graphics/common.hpp"
+#include "graphics/frustum.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Chunk;
+class PaddedChunk;
+
+// Which faces of a 16x16x16 section can see each other through it: two faces are connected if a path of
+// transparent blocks joins them. Faces are indexed like VoxelQuad::Face. Computed when the chunk is meshed and
+// used by find_visible_sections to skip sections that cannot be seen from the camera, such as closed caves.
+class SectionVisibility {
+public:
+    // Every face connected to every other, used for all-air sections and chunks that are not meshed yet
+    static SectionVisibility all_connected();
+    static SectionVisibility compute(const PaddedChunk& padded_chunk, int section_index);
+
+    bool are_connected(int face_a, int face_b) const;
+    void connect(int face_a, int face_b);
+
+private:
+    // bit 6 * a + b is set if faces a and b are connected, kept symmetric
+    uint64_t connections = 0;
+};
+
+using ChunkVisibility = std::array<SectionVisibility, SECTIONS_PER_CHUNK>;
+
+ChunkVisibility compute_chunk_visibility(const PaddedChunk& padded_chunk);
+
+// Breadth first search over the sections of the loaded chunks, starting from the camera section and only moving
+// away from it. A section is entered through one face and left through the faces connected to it, and only
+// if it is inside the frustum. Sets visible_sections[i] to the mask of reachable sections of loaded_chunks[i].
+void find_visible_sections(glm::vec3 camera_position,
+                           const Frustum& frustum,
+                           const std::vector<Chunk>& loaded_chunks,
+                           const std::unordered_map<glm::ivec2, size_t>& chunk_index_map,
+                           std::vector<uint16_t>& visible_sections);
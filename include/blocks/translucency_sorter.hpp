@@ -0,0 +1,71 @@
+#pragma once
+
+#include "blocks/chunk_mesher.hpp"
+#include "graphics/common.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct SortJob {
+    glm::ivec2 chunk_coords{};
+    // unique per job, used by the owner to recognize results that were invalidated while sorting
+    uint64_t version{};
+    // relative to the chunk origin
+    glm::vec3 camera_pos{};
+    // packed QuadRecords of the chunk's translucent quads
+    std::vector<uint32_t> quad_data{};
+    // translucent quads of each section, every section is sorted within its own range
+    SectionQuadOffsets sections{};
+};
+
+struct SortResult {
+    glm::ivec2 chunk_coords{};
+    uint64_t version{};
+    std::vector<uint32_t> quad_data{};
+};
+
+// Orders the translucent quads of each section of chunks back to front on a worker thread, so that blending them in
+// buffer order composites them correctly. The sections themselves are ordered when they are drawn. A chunk has at most one queued job: a newer camera position replaces the queued one,
+// since the older order would be outdated before it was uploaded.
+class TranslucencySorter {
+public:
+    TranslucencySorter();
+    ~TranslucencySorter();
+
+    TranslucencySorter(const TranslucencySorter&) = delete;
+    TranslucencySorter& operator=(const TranslucencySorter&) = delete;
+    TranslucencySorter(TranslucencySorter&&) = delete;
+    TranslucencySorter& operator=(TranslucencySorter&&) = delete;
+
+    // Sorts the packed QuadRecords of each section by decreasing distance from camera_pos to their centers, both
+    // relative to the chunk. Quads stay in the range of their section
+    static void sort_back_to_front(std::vector<uint32_t>& quad_data, const SectionQuadOffsets& sections,
+                                   glm::vec3 camera_pos);
+
+    void submit(SortJob job);
+    std::vector<SortResult> take_results();
+    // Blocks until every submitted job has finished
+    void wait_idle();
+
+private:
+    void worker_loop();
+
+    // the queued job of each chunk, and the chunks with a queued job in submission order. A chunk keeps its place
+    // in the queue when its job is replaced
+    std::unordered_map<glm::ivec2, SortJob> queued_jobs{};
+    std::deque<glm::ivec2> job_order{};
+    std::vector<SortResult> results{};
+    bool sorting = false;
+    bool stopping = false;
+
+    std::mutex mutex{};
+    std::condition_variable job_available{};
+    std::condition_variable jobs_finished{};
+    // started last, once everything it uses is constructed
+    std::thread worker{};
+};
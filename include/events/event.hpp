@@ -28,6 +28,8 @@ struct ApplicationEvent {
         CloseWindow,
         ToggleCursor,
         ReloadShaders,
+        ToggleMeshingMode,
+        ToggleRenderStats,
     } type{};
 };
 
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+
+struct BufferRange {
+    size_t offset{};
+    size_t size{};
+};
+
+struct BufferAllocatorStats {
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t n_allocations = 0;
+    size_t n_free_ranges = 0;
+    size_t largest_free_range = 0;
+};
+
+// Suballocates ranges of one large buffer using a best fit free list; freed ranges are merged with their free
+// neighbors. Offsets and sizes are in units chosen by the caller. The allocator only does the bookkeeping and never
+// touches the buffer itself, so it works without a GL context.
+class BufferAllocator {
+public:
+    explicit BufferAllocator(size_t capacity);
+
+    // Returns the smallest free range that fits, or nullopt if there is none. A size of 0 gives an empty range
+    std::optional<BufferRange> allocate(size_t size);
+    void free(BufferRange range);
+    // Adds free space at the end of the buffer, e.g. after it was reallocated larger
+    void grow(size_t new_capacity);
+
+    size_t get_capacity() const;
+    BufferAllocatorStats get_stats() const;
+
+private:
+    void add_free_range(size_t offset, size_t size);
+    void remove_free_range(std::map<size_t, size_t>::iterator it);
+
+    size_t capacity;
+    size_t used = 0;
+    size_t n_allocations = 0;
+
+    // offset -> size, used to find the neighbors of a freed range
+    std::map<size_t, size_t> free_by_offset{};
+    // (size, offset), used to find the best fit
+    std::set<std::pair<size_t, size_t>> free_by_size{};
+};
@@ -12,9 +12,11 @@
 #include "glm/gtx/hash.hpp"
 
 struct RenderCall {
-    glm::mat4 transform;
+    // world position of the mesh origin, meshes are never rotated or scaled
+    glm::vec3 origin;
     GLuint VAO;
+    size_t first_vertex;
     GLuint shader_id;
     GLuint texture_unit;
-    size_t n_vertices;
+    size_t n_indices;
 };
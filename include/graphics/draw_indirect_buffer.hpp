@@ -0,0 +1,49 @@
+#pragma once
+
+#include "graphics/common.hpp"
+
+#include <cstddef>
+#include <vector>
+
+// Layout of one glMultiDrawElementsIndirect command, fixed by OpenGL
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance;
+};
+
+// Collects the render calls of one pass into an indirect command buffer and a storage buffer of per draw origins,
+// so that the whole pass is submitted with a single glMultiDrawElementsIndirect. Shaders read the origin of their
+// draw as origins[gl_DrawID].xyz instead of a model matrix uniform, and the layer it was added with, such as a
+// shadow cascade, as origins[gl_DrawID].w. All calls must share a VAO.
+class DrawIndirectBuffer {
+public:
+    // must match the ChunkDraws binding in voxel.vert and depth.vert
+    static constexpr GLuint DRAW_DATA_BINDING = 2;
+
+    DrawIndirectBuffer() = default;
+    ~DrawIndirectBuffer();
+
+    DrawIndirectBuffer(const DrawIndirectBuffer&) = delete;
+    DrawIndirectBuffer& operator=(const DrawIndirectBuffer&) = delete;
+    DrawIndirectBuffer(DrawIndirectBuffer&&) = delete;
+    DrawIndirectBuffer& operator=(DrawIndirectBuffer&&) = delete;
+
+    void clear();
+    void add(const RenderCall& render_call, int layer = 0);
+    // Uploads the calls added since the last clear and draws them with the bound program
+    void draw();
+    size_t size() const;
+    // Deletes the buffers while the GL context is still current, the next draw creates them again
+    void destroy();
+
+private:
+    GLuint VAO{};
+    GLuint command_buffer{};
+    GLuint draw_data_buffer{};
+    std::vector<DrawElementsIndirectCommand> commands{};
+    // vec4 to match the std430 array stride
+    std::vector<glm::vec4> origins{};
+};
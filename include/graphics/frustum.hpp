@@ -0,0 +1,56 @@
+#pragma once
+
+#include "graphics/common.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct AABB {
+    glm::vec3 min{};
+    glm::vec3 max{};
+};
+
+// Axis aligned boxes stored as centers and half extents in separate arrays, so that Frustum::cull tests a whole
+// batch with straight-line loops the compiler can vectorize. The arrays are padded to a multiple of LANES with
+// NaN boxes, which fail every plane test.
+struct AABBBatch {
+    static constexpr size_t LANES = 16;
+
+    std::vector<float> center_x{};
+    std::vector<float> center_y{};
+    std::vector<float> center_z{};
+    std::vector<float> extent_x{};
+    std::vector<float> extent_y{};
+    std::vector<float> extent_z{};
+    size_t n_boxes = 0;
+
+    void add(const AABB& box);
+    void clear();
+    size_t size() const;
+};
+
+// Per frame counts of the boxes a culling pass kept and rejected
+struct CullingStats {
+    size_t drawn = 0;
+    size_t culled = 0;
+};
+
+// View frustum as six inward facing planes, extracted from a projection * view matrix. A default constructed
+// frustum contains everything.
+class Frustum {
+public:
+    Frustum() = default;
+    explicit Frustum(const glm::mat4& view_projection);
+
+    // Conservative test: boxes near the frustum corners may be reported as intersecting
+    bool intersects_aabb(glm::vec3 min, glm::vec3 max) const;
+    // Same test as intersects_aabb for every box of the batch, sets visible[i] to 1 if box i intersects and 0
+    // otherwise. Returns the number of intersecting boxes
+    size_t cull(const AABBBatch& boxes, std::vector<uint32_t>& visible) const;
+
+private:
+    // (a, b, c, d) with a * x + b * y + c * z + d >= 0 on the inside
+    std::array<glm::vec4, 6> planes{};
+};
@@ -19,16 +19,6 @@ public:
                                         const std::filesystem::path& fragment_path,
                                         const std::filesystem::path& geometry_path);
 
-    static void set_uniform(GLuint program_id, const std::string& name, bool value);
-    static void set_uniform(GLuint program_id, const std::string& name, int value);
-    static void set_uniform(GLuint program_id, const std::string& name, float value);
-    static void set_uniform(GLuint program_id, const std::string& name, const glm::vec2& value);
-    static void set_uniform(GLuint program_id, const std::string& name, const glm::vec3& value);
-    static void set_uniform(GLuint program_id, const std::string& name, const glm::vec4& value);
-    static void set_uniform(GLuint program_id, const std::string& name, const glm::mat2& value);
-    static void set_uniform(GLuint program_id, const std::string& name, const glm::mat3& value);
-    static void set_uniform(GLuint program_id, const std::string& name, const glm::mat4& value);
-
 private:
     static std::optional<std::string> parse_file(const std::filesystem::path& file_path);
     static std::optional<GLuint> compile(const std::string& source, Shader::Type type);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "graphics/common.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// An OpenGL program built from shader files that can be rebuilt in place. Uniform locations are looked up by name
+// once, when a uniform is registered and after every successful load, so setting a uniform in the render loop is
+// a table lookup and a glUniform call, without strings or glGetUniformLocation.
+class ShaderProgram {
+public:
+    // Typed handle to a registered uniform, stays valid across reloads
+    template <typename T>
+    struct Uniform {
+        size_t index{};
+    };
+
+    // The program is only built by load(), so it can be constructed before the GL context
+    ShaderProgram(std::filesystem::path vertex_path, std::filesystem::path fragment_path);
+    ShaderProgram(std::filesystem::path vertex_path, std::filesystem::path fragment_path, std::filesystem::path geometry_path);
+    ~ShaderProgram();
+
+    ShaderProgram(const ShaderProgram&) = delete;
+    ShaderProgram& operator=(const ShaderProgram&) = delete;
+    ShaderProgram(ShaderProgram&&) = delete;
+    ShaderProgram& operator=(ShaderProgram&&) = delete;
+
+    // Compiles and links the program from its files. On failure the previous program, if any, is kept
+    bool load();
+    // Deletes the program while the GL context is still current, load() builds it again
+    void destroy();
+    void use() const;
+    GLuint id() const;
+
+    template <typename T>
+    Uniform<T> uniform(const std::string& name) {
+        return { add_uniform(name) };
+    }
+
+    // The program must be in use
+    void set(Uniform<bool> uniform, bool value) const;
+    void set(Uniform<int> uniform, int value) const;
+    void set(Uniform<float> uniform, float value) const;
+    void set(Uniform<glm::vec2> uniform, const glm::vec2& value) const;
+    void set(Uniform<glm::vec3> uniform, const glm::vec3& value) const;
+    void set(Uniform<glm::vec4> uniform, const glm::vec4& value) const;
+    void set(Uniform<glm::mat2> uniform, const glm::mat2& value) const;
+    void set(Uniform<glm::mat3> uniform, const glm::mat3& value) const;
+    void set(Uniform<glm::mat4> uniform, const glm::mat4& value) const;
+
+private:
+    size_t add_uniform(const std::string& name);
+    void resolve_uniform(size_t index);
+
+    std::filesystem::path vertex_path{};
+    std::filesystem::path fragment_path{};
+    std::filesystem::path geometry_path{};
+    GLuint program_id{};
+
+    std::vector<std::string> uniform_names{};
+    // -1 for uniforms the program does not use, which glUniform ignores
+    std::vector<GLint> uniform_locations{};
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "graphics/common.hpp"
+#include "graphics/frustum.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per cascade lists of shadow casters: the indices of the caster boxes that intersect the light space box of each
+// cascade, so that every cascade only draws its own casters. Uses no GL state.
+class ShadowCasterSelection {
+public:
+    // Rebuilds the list of every cascade whose bit is set in cascade_mask from the boxes inside the cascade's
+    // light matrix; the lists of the other cascades are emptied. Indices are in increasing order
+    void select(const std::vector<glm::mat4>& light_matrices, int cascade_mask, const AABBBatch& caster_bounds);
+    const std::vector<uint32_t>& get_casters(int cascade_index) const;
+    // Sum of the list sizes, the number of draws needed for all selected cascades
+    size_t total_casters() const;
+
+private:
+    std::vector<std::vector<uint32_t>> cascade_casters{};
+    std::vector<uint32_t> visibility{};
+};
@@ -1,21 +1,44 @@
 #pragma once
 
 #include "graphics/common.hpp"
+#include "graphics/draw_indirect_buffer.hpp"
+#include "graphics/frustum.hpp"
+#include "graphics/shader_program.hpp"
+#include "graphics/shadow_casters.hpp"
 #include "systems/camera.hpp"
+
+#include <array>
+#include <cstdint>
 #include <vector>
 
 constexpr int CASCADE_LEVELS = 4;
+// Cascades from this one on are refreshed one per frame in turn once they have been drawn
+constexpr int FIRST_ROUND_ROBIN_CASCADE = 2;
 
 class ShadowMap {
 public:
     ShadowMap(int width, int height, CameraSystem* camera_system);
+    ~ShadowMap();
     ShadowMap(const ShadowMap&) = delete;
-    ShadowMap(ShadowMap&&) noexcept = default;
+    ShadowMap(ShadowMap&&) = delete;
     ShadowMap& operator=(const ShadowMap&) = delete;
-    ShadowMap& operator=(ShadowMap&&) noexcept = default;
+    ShadowMap& operator=(ShadowMap&&) = delete;
 
-    void shadow_pass(const std::vector<RenderCall>& render_queue);
+    // caster_bounds[i] is the world space box of render_queue[i]; each redrawn cascade only draws the calls inside
+    // it. Cascades are cached: one is only redrawn when its light matrix changed or casters inside it were
+    // invalidated, and far cascades at most one per frame
+    void shadow_pass(const std::vector<RenderCall>& render_queue, const AABBBatch& caster_bounds);
+    // Marks the cached cascades that contain bounds to be redrawn, for meshes that were changed or removed
+    void invalidate(const AABB& bounds);
+    // Rebuilds the depth program from its files, keeping the current one on failure
+    bool reload_shader();
     GLuint get_unit() const;
+    // Casters drawn and culled by the last shadow pass, summed over the redrawn cascades
+    CullingStats get_culling_stats() const;
+    // Casters inside cascade_index in the last shadow pass that redrew it
+    size_t get_cascade_caster_count(int cascade_index) const;
+    // Number of times cascade_index was redrawn since startup
+    size_t get_cascade_update_count(int cascade_index) const;
 
     int width{};
     int height{};
@@ -31,6 +54,22 @@ private:
     GLuint FBO{};
     GLuint texture_id{};
     GLuint texture_unit{};
-    GLuint depth_shader{};
+    ShaderProgram depth_shader{ "data/shaders/depth.vert", "data/shaders/depth.frag" };
     GLuint matrices_UBO{};
+    // with vertex shader layer selection all cascades are drawn by one multi-draw into the layered framebuffer,
+    // otherwise each cascade is drawn separately with only its layer attached
+    bool layered_rendering = false;
+
+    DrawIndirectBuffer draw_buffer{};
+    ShadowCasterSelection caster_selection{};
+    CullingStats culling_stats{};
+    std::array<size_t, CASCADE_LEVELS> cascade_caster_counts{};
+
+    // light matrix each layer of the shadow map was last drawn with, which is also the one sent to the UBO
+    std::array<glm::mat4, CASCADE_LEVELS> cascade_matrices{};
+    std::array<bool, CASCADE_LEVELS> cascade_drawn{};
+    // drawn cascades containing casters that changed since
+    std::array<bool, CASCADE_LEVELS> cascade_dirty{};
+    std::array<size_t, CASCADE_LEVELS> cascade_update_counts{};
+    int next_round_robin_cascade = FIRST_ROUND_ROBIN_CASCADE;
 };
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "blocks/chunk_store.hpp"
+#include "blocks/far_terrain.hpp"
+#include "networking/session.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Counters of a ChunkService since startup, along with the state of its ChunkStore
+struct ChunkServiceStats {
+    ChunkStoreStats store{};
+    size_t n_chunks = 0;
+    size_t memory_usage = 0;
+    size_t memory_budget = 0;
+    // requests that waited for a chunk already being generated for another request
+    size_t coalesced = 0;
+    // chunks queued or being generated
+    size_t in_flight = 0;
+    // far terrain tiles waiting for a worker
+    size_t far_tiles_queued = 0;
+};
+
+// Answers ChunkRequests on the server. Stored chunks are sent right away; missing chunks are generated and encoded on
+// a fixed number of worker threads, so that the thread running the sessions only does lookups. Requests for a chunk
+// that is already queued, e.g. from several clients joining in the same area, wait for the same job. Finished packets
+// are posted to the executor of every waiting session. FarTerrainRequests are generated by the same workers after any
+// queued chunks, since nearby chunks matter more than the horizon. Thread safe.
+class ChunkService {
+public:
+    ChunkService(size_t cache_budget, int num_threads);
+    ~ChunkService();
+
+    ChunkService(const ChunkService&) = delete;
+    ChunkService& operator=(const ChunkService&) = delete;
+    ChunkService(ChunkService&&) = delete;
+    ChunkService& operator=(ChunkService&&) = delete;
+
+    // The hardware threads not used by the num_network_threads threads running the sessions, at least one
+    static int default_num_threads(int num_network_threads);
+
+    void request(std::shared_ptr<Session> session, const ChunkRequest& request);
+    void request_far_terrain(std::shared_ptr<Session> session, const FarTerrainRequest& request);
+    ChunkServiceStats get_stats() const;
+
+private:
+    struct FarTerrainJob {
+        std::shared_ptr<Session> session;
+        FarTerrainRequest request;
+    };
+
+    void worker_loop();
+    void generate_chunk(ChunkStore::Key key);
+    void generate_far_tile(FarTerrainJob job);
+
+    ChunkStore chunk_store;
+    // sessions waiting for each queued or generating chunk
+    std::unordered_map<ChunkStore::Key, std::vector<std::shared_ptr<Session>>, ChunkStore::KeyHash> waiting_sessions{};
+    std::deque<ChunkStore::Key> jobs{};
+    std::deque<FarTerrainJob> far_terrain_jobs{};
+    size_t n_coalesced = 0;
+    bool stopping = false;
+
+    std::vector<std::thread> workers{};
+    mutable std::mutex mutex{};
+    std::condition_variable job_available{};
+};
@@ -9,6 +9,8 @@ enum class PacketType : uint16_t {
     Pong,
     ChunkRequest,
     ChunkData,
+    FarTerrainRequest,
+    FarTerrainData,
 };
 
 struct PacketHeader {
@@ -4,31 +4,57 @@
 #include "networking/session.hpp"
 #include "networking/packet.hpp"
 
+#include <chrono>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 
+// Each Session runs on its own strand, so its packet handlers never run concurrently with each other or with its
+// writes, but handlers of different sessions may run at the same time on different threads of run.
 class ServerInterface {
 public:
     using PacketHandler = std::function<void(std::shared_ptr<Session>, Packet)>;
+    using TickHandler = std::function<void()>;
 
     explicit ServerInterface(uint16_t port);
 
+    // Handlers must be registered before the server is polled or run
     void register_packet_handler(PacketType type, PacketHandler handler);
+    // Called every interval while the server runs, on one thread at a time. Ticks that are missed because a handler
+    // took too long are skipped instead of run back to back. Must be set before the server is polled or run
+    void set_tick_handler(std::chrono::steady_clock::duration interval, TickHandler handler);
     void send_to(std::shared_ptr<Session> session, Packet packet);
     void broadcast(const Packet& packet, std::shared_ptr<Session> exclude = nullptr);
 
+    // Runs the handlers that are ready without blocking, on the calling thread
     void poll();
+    // Runs the server on the calling thread and num_threads - 1 others until stop is called
+    void run(int num_threads);
+    // Makes run return. Can be called from any thread, including from handlers
+    void stop();
     size_t client_count() const;
 
+    // A quarter of the hardware threads, at most MAX_DEFAULT_THREADS: sessions only parse packets, look up stored
+    // chunks and write, so the rest of the cores are left to the ChunkService workers
+    static int default_num_threads();
+    static constexpr int MAX_DEFAULT_THREADS = 2;
+
 private:
     asio::awaitable<void> accept_loop();
+    asio::awaitable<void> tick_loop();
+    void start_ticks();
 
     asio::io_context io_context{};
     asio::ip::tcp::acceptor acceptor;
     std::unordered_map<PacketType, PacketHandler> handlers{};
+    std::chrono::steady_clock::duration tick_interval{};
+    TickHandler tick_handler{};
+    bool is_ticking = false;
+
+    // sessions are added by accept_loop and removed from the strand of the closing session
+    mutable std::mutex sessions_mutex{};
     std::unordered_map<uint64_t, std::shared_ptr<Session>> sessions{};
     uint64_t next_id = 1;
 };
-
@@ -3,9 +3,22 @@
 #include "asio.hpp"
 #include "networking/packet.hpp"
 
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <deque>
+#include <vector>
+
+// Counters of the writes of a Session. A batch is every packet queued while the previous batch was being written,
+// sent as one gathered write of their headers and payloads
+struct SessionWriteStats {
+    size_t batches = 0;
+    size_t packets = 0;
+    size_t bytes = 0;
+    // write_some calls, one writev/sendmsg each. Above 1 per batch when the socket buffer fills up or a batch has
+    // more buffers than one call accepts
+    size_t writes = 0;
+};
 
 class Session : public std::enable_shared_from_this<Session> {
 public:
@@ -15,9 +28,14 @@ public:
     explicit Session(asio::ip::tcp::socket socket) : socket(std::move(socket)) {};
 
     void start(PacketHandler on_packet, CloseHandler on_close);
+    // Must be called from the executor of the session. Packets sent after the session closed are dropped
     void send(Packet packet);
     void close();
     asio::ip::tcp::endpoint remote_endpoint() const;
+    // Executor that runs the reads and writes of the session, to post work that uses the session to
+    asio::any_io_executor get_executor();
+    // Must be called from the executor of the session
+    const SessionWriteStats& get_write_stats() const;
 
 private:
     asio::awaitable<void> read_loop();
@@ -27,6 +45,10 @@ private:
     PacketHandler on_packet{};
     CloseHandler on_close{};
     std::deque<Packet> write_queue{};
+    // packets being written and their header and payload buffers, swapped with write_queue for every batch
+    std::deque<Packet> write_batch{};
+    std::vector<asio::const_buffer> write_buffers{};
+    SessionWriteStats write_stats{};
     bool is_writing = false;
     bool is_closing = false;
 };
@@ -5,23 +5,37 @@
 
 #include "blocks/chunk.hpp"
 #include "blocks/chunk_manager.hpp"
-#include "graphics/shader.hpp"
 #include "graphics/shadow_map.hpp"
 #include "graphics/texture_manager.hpp"
 #include "utils/logger.hpp"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
+#include <numeric>
 
-ClientApplication::ClientApplication(int width, int height, std::string hostname, uint16_t port)
-    : width(width), height(height), hostname(hostname), port(port), window(nullptr)
+ClientApplication::ClientApplication(int width, int height, std::string hostname, uint16_t port, int benchmark_frames)
+    : width(width), height(height), hostname(hostname), port(port), window(nullptr), benchmark_frames(benchmark_frames)
 {
     if (!glfwInit()) {
         throw std::runtime_error("[ClientApplication] Cannot initialize GLFW");
     }
 
+    if (benchmark_frames > 0) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+
     window = std::make_unique<Window>(width, height, "Blockcraft Client");
     window->create();
 
+    // benchmark frames are not limited by vsync
+    if (benchmark_frames > 0) {
+        glfwSwapInterval(0);
+    }
+
     // save a pointer to this ClientApplication instance; to be accessed in callbacks
     glfwSetWindowUserPointer(window->ptr(), this);
 
@@ -40,6 +54,17 @@ ClientApplication::ClientApplication(int width, int height, std::string hostname
 }
 
 ClientApplication::~ClientApplication() {
+    // everything that owns GL objects goes before the context
+    shadow_map.reset();
+    far_terrain.reset();
+    draw_buffer.destroy();
+    voxel_shader.destroy();
+    hud_shader.destroy();
+    if (HUD_VAO) {
+        glDeleteBuffers(1, &HUD_VBO);
+        glDeleteVertexArrays(1, &HUD_VAO);
+    }
+
     window->destroy();
     glfwTerminate();
 }
@@ -52,12 +77,21 @@ void ClientApplication::run() {
     glEnable(GL_CULL_FACE);
     glCullFace(GL_BACK);
 
-    voxel_shader = Shader::create("data/shaders/voxel.vert", "data/shaders/voxel.frag").value_or(0);
-    if (!voxel_shader) {
+    if (!voxel_shader.load()) {
         return;
     }
+    voxel_uniforms = {
+        voxel_shader.uniform<glm::mat4>("view"),
+        voxel_shader.uniform<glm::mat4>("projection"),
+        voxel_shader.uniform<glm::vec3>("cameraPos"),
+        voxel_shader.uniform<float>("renderRadius"),
+        voxel_shader.uniform<int>("depthMap"),
+        voxel_shader.uniform<glm::vec3>("lightPos"),
+        voxel_shader.uniform<int>("textureId"),
+    };
 
     TextureManager texture_manager;
+    block_texture_unit = texture_manager.get_texture_unit();
 
     int seed = 2345;
     chunk_radius = 8;
@@ -104,12 +138,12 @@ void ClientApplication::run() {
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    GLuint hud_shader = Shader::create("data/shaders/hud.vert", "data/shaders/hud.frag").value_or(0);
-    if (!hud_shader) {
+    if (!hud_shader.load()) {
         return;
     }
 
     shadow_map = std::make_unique<ShadowMap>(SHADOW_WIDTH, SHADOW_HEIGHT, camera_system);
+    far_terrain = std::make_unique<FarTerrain>(seed, chunk_radius, far_radius);
 
     ClientInterface client;
 
@@ -126,15 +160,31 @@ void ClientApplication::run() {
         chunk_manager.receive_chunk_data(std::move(packet));
     });
 
-    client.connect(this->hostname, this->port);
+    client.register_packet_handler(PacketType::FarTerrainData, [this](Packet packet){
+        far_terrain->receive_tile_data(std::move(packet));
+    });
 
-    // wait for connection
-    while (!client.is_connected()) {
-        client.poll();
+    // benchmarks generate their chunks locally and do not need a server
+    bool benchmark = benchmark_frames > 0;
+    if (!benchmark) {
+        client.connect(this->hostname, this->port);
+
+        // wait for connection
+        while (!client.is_connected()) {
+            client.poll();
+        }
     }
 
     chunk_manager.update({8.0f, 8.0f, 160.0f});
-    chunk_manager.request_all_chunks(client);
+    chunk_manager.set_view(camera_system->camera_position(), camera_system->projection() * camera_system->view());
+    far_terrain->update({8.0f, 8.0f, 160.0f});
+    if (benchmark) {
+        chunk_manager.generate_requested_chunks();
+        far_terrain->generate_requested_tiles();
+    } else {
+        chunk_manager.request_all_chunks(client);
+        far_terrain->request_all_tiles(client);
+    }
     chunk_manager.load_all_chunks();
     chunk_manager.mesh_all_chunks(texture_manager);
 
@@ -147,9 +197,35 @@ void ClientApplication::run() {
         movement_system->update(dt, chunk_manager);
         physics_system->update(dt);
 
-        chunk_manager.request_all_chunks(client);
+        far_terrain->update(camera_system->camera_position());
+        if (benchmark) {
+            chunk_manager.generate_requested_chunks();
+            far_terrain->generate_requested_tiles();
+        } else {
+            chunk_manager.request_all_chunks(client);
+            far_terrain->request_all_tiles(client);
+        }
         chunk_manager.load_chunks(1);
+        far_terrain->load_tiles(16, texture_manager);
         chunk_manager.unload_chunks(1);
+        chunk_manager.set_view(camera_system->camera_position(), camera_system->projection() * camera_system->view());
+
+        // remesh everything at once so the debug log reports the time and vertex count of the new mesher
+        if (toggle_meshing_mode) {
+            switch (chunk_manager.get_meshing_mode()) {
+                case MeshingMode::PerFace:
+                    chunk_manager.set_meshing_mode(MeshingMode::Greedy);
+                    break;
+                case MeshingMode::Greedy:
+                    chunk_manager.set_meshing_mode(MeshingMode::Binary);
+                    break;
+                case MeshingMode::Binary:
+                    chunk_manager.set_meshing_mode(MeshingMode::PerFace);
+                    break;
+            }
+            chunk_manager.mesh_all_chunks(texture_manager);
+            toggle_meshing_mode = false;
+        }
         chunk_manager.mesh_chunks(5, texture_manager);
 
         if (frame_time >= 1.0f / BLOCKS_PER_SECOND) {
@@ -157,26 +233,66 @@ void ClientApplication::run() {
             frame_time -= (1.0f / BLOCKS_PER_SECOND);
         }
 
-        glUseProgram(voxel_shader);
-        glm::mat4 identity(1.0f);
+        // CPU submit time: building, culling and submitting both passes, without waiting for the GPU
+        auto submit_start = std::chrono::steady_clock::now();
 
         for (const auto& chunk : chunk_manager.get_chunks()) {
+            if (chunk.get_num_quads() == 0) {
+                continue;
+            }
+
+            covered_chunks.push_back(chunk.get_chunk_coords());
+            render_bounds.add(chunk.get_world_bounds());
+            render_sections.push_back(chunk_manager.get_visible_sections(chunk.get_chunk_coords()));
+            size_t first_quad = chunk_manager.get_chunk_first_quad(chunk.get_chunk_coords());
+            render_section_ranges.push_back({ first_quad, chunk.get_opaque_sections(), chunk.get_translucent_sections() });
             render_queue.emplace_back(
-                glm::translate(identity, chunk.to_world_pos(glm::vec3(0.0f))),
+                chunk.to_world_pos(glm::vec3(0.0f)),
                 chunk_manager.get_chunk_VAO(chunk.get_chunk_coords()),
-                voxel_shader,
+                first_quad * VERTICES_PER_QUAD,
+                voxel_shader.id(),
                 texture_manager.get_texture_unit(),
-                chunk.get_num_vertices()
+                chunk.get_num_opaque_quads() * INDICES_PER_QUAD
             );
         }
         //glm::mat4 rotation = glm::rotate(identity, (float)glfwGetTime() * 0.2f, glm::vec3(0.0f, 1.0f, 0.0f));
         //shadow_map->light_pos = rotation * glm::vec4(0.1f, 0.2f, 0.7f, 1.0f);
-        shadow_map->shadow_pass(render_queue);
+        for (const AABB& bounds : chunk_manager.take_changed_mesh_bounds()) {
+            shadow_map->invalidate(bounds);
+        }
+        shadow_map->shadow_pass(render_queue, render_bounds);
+        far_terrain->set_covered_chunks(covered_chunks);
+        this->cull_render_queue();
         this->render();
+        if (benchmark) {
+            benchmark_submit_times.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - submit_start).count());
+            benchmark_draws += opaque_render_queue.size() + translucent_render_queue.size() + shadow_map->get_culling_stats().drawn;
+        }
         render_queue.clear();
+        opaque_render_queue.clear();
+        translucent_render_queue.clear();
+        render_bounds.clear();
+        render_sections.clear();
+        render_section_ranges.clear();
+        covered_chunks.clear();
+
+        render_stats_log_time += dt;
+        if (log_render_stats && render_stats_log_time >= 1.0f) {
+            RenderStats stats = get_render_stats();
+            log_debug("Chunks drawn: %zu, culled: %zu (%zu occluded); shadow casters drawn: %zu, culled: %zu",
+                      stats.chunks.drawn, stats.chunks.culled, stats.n_occluded_chunks,
+                      stats.shadow_casters.drawn, stats.shadow_casters.culled);
+            log_debug("Sections occluded in drawn chunks: %zu, section draws: %zu",
+                      stats.n_occluded_sections, stats.n_section_draws);
+            for (int i = 0; i < CASCADE_LEVELS; i++) {
+                log_debug("Shadow cascade %d casters: %zu, redrawn %zu times", i, stats.cascade_casters[i], stats.cascade_updates[i]);
+            }
+            log_debug("Far terrain tiles: %zu, %zu KiB", stats.n_far_tiles, stats.far_terrain_memory / 1024);
+            render_stats_log_time = 0.0f;
+        }
 
         glBindVertexArray(this->HUD_VAO);
-        glUseProgram(hud_shader);
+        hud_shader.use();
         glLineWidth(3.0f);
         glDrawArrays(GL_LINES, 0, 4);
 
@@ -184,14 +300,48 @@ void ClientApplication::run() {
 
         client.poll();
 
-        if (window->should_close()) {
+        if (window->should_close() || (benchmark && benchmark_submit_times.size() >= static_cast<size_t>(benchmark_frames))) {
             this->stop();
         }
     }
 
+    if (benchmark) {
+        report_benchmark();
+    }
     client.disconnect();
 }
 
+void ClientApplication::report_benchmark() const {
+    if (benchmark_submit_times.empty()) {
+        return;
+    }
+
+    std::vector<float> times = benchmark_submit_times;
+    std::sort(times.begin(), times.end());
+    float total = std::accumulate(times.begin(), times.end(), 0.0f);
+
+    std::printf("[Benchmark] %s, %zu frames, %.1f draws per frame (both passes)\n",
+                reinterpret_cast<const char*>(glGetString(GL_RENDERER)), times.size(), static_cast<float>(benchmark_draws) / times.size());
+    std::printf("[Benchmark] CPU submit time per frame: mean %.3f ms, median %.3f ms, min %.3f ms, max %.3f ms\n",
+                total / times.size(), times[times.size() / 2], times.front(), times.back());
+}
+
+RenderStats ClientApplication::get_render_stats() const {
+    RenderStats stats{};
+    stats.chunks = culling_stats;
+    stats.n_occluded_chunks = n_occluded_chunks;
+    stats.n_occluded_sections = n_occluded_sections;
+    stats.n_section_draws = opaque_render_queue.size() + translucent_render_queue.size();
+    stats.shadow_casters = shadow_map->get_culling_stats();
+    for (int i = 0; i < CASCADE_LEVELS; i++) {
+        stats.cascade_casters[i] = shadow_map->get_cascade_caster_count(i);
+        stats.cascade_updates[i] = shadow_map->get_cascade_update_count(i);
+    }
+    stats.n_far_tiles = far_terrain->get_num_tiles();
+    stats.far_terrain_memory = far_terrain->get_memory_usage();
+    return stats;
+}
+
 // Update application specific events and fields
 void ClientApplication::update() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -217,39 +367,157 @@ void ClientApplication::update() {
                     movement_system->reset_first_mouse();
                 }
                 break;
+            case ApplicationEvent::Type::ToggleMeshingMode:
+                toggle_meshing_mode = true;
+                break;
+            case ApplicationEvent::Type::ToggleRenderStats:
+                log_render_stats = !log_render_stats;
+                render_stats_log_time = 1.0f;
+                break;
             case ApplicationEvent::Type::ReloadShaders:
-                std::optional<GLuint> new_shader = Shader::create("data/shaders/voxel.vert", "data/shaders/voxel.frag");
-                if (!voxel_shader) {
+                // every program is rebuilt, one that fails keeps its previous version
+                log_debug("Reloading shaders");
+                bool voxel_loaded = voxel_shader.load();
+                bool hud_loaded = hud_shader.load();
+                bool depth_loaded = shadow_map->reload_shader();
+                bool far_terrain_loaded = far_terrain->reload_shader();
+                if (!voxel_loaded || !hud_loaded || !depth_loaded || !far_terrain_loaded) {
                     log_error("Error reloading shaders");
-                    break;
                 }
-                log_debug("Reloading shaders");
-                glDeleteProgram(voxel_shader);
-                voxel_shader = *new_shader;
                 break;
         }
     }
 }
 
+void ClientApplication::cull_render_queue() {
+    Frustum view_frustum(camera_system->projection() * camera_system->view());
+    view_frustum.cull(render_bounds, render_visibility);
+
+    // translucent sections are queued nearest to the camera height first, so that the stable sort by chunk distance
+    // in render leaves the sections of each chunk in order
+    std::array<int, SECTIONS_PER_CHUNK> section_order{};
+    std::iota(section_order.begin(), section_order.end(), 0);
+    float camera_z = camera_system->camera_position().z;
+    std::stable_sort(section_order.begin(), section_order.end(), [camera_z](int a, int b) {
+        return std::abs((a + 0.5f) * SECTION_HEIGHT - camera_z) < std::abs((b + 0.5f) * SECTION_HEIGHT - camera_z);
+    });
+
+    // shadow casters were already drawn from the full queue, occlusion only applies to the camera
+    size_t n_kept = 0;
+    n_occluded_chunks = 0;
+    n_occluded_sections = 0;
+    for (size_t i = 0; i < render_queue.size(); i++) {
+        if (!render_visibility[i]) {
+            continue;
+        }
+        uint16_t sections = render_sections[i];
+        if (sections == 0) {
+            n_occluded_chunks++;
+            continue;
+        }
+        n_kept++;
+
+        const RenderCall& chunk_call = render_queue[i];
+        const ChunkSectionRanges& ranges = render_section_ranges[i];
+        auto section_call = [&chunk_call](size_t first_quad, size_t n_quads) {
+            RenderCall render_call = chunk_call;
+            render_call.first_vertex = first_quad * VERTICES_PER_QUAD;
+            render_call.n_indices = n_quads * INDICES_PER_QUAD;
+            return render_call;
+        };
+
+        // the quads of consecutive sections are contiguous, so each run of visible sections is a single draw
+        int section_index = 0;
+        while (section_index < SECTIONS_PER_CHUNK) {
+            if (!(sections & (1 << section_index))) {
+                bool has_quads = ranges.opaque_sections[section_index + 1] > ranges.opaque_sections[section_index]
+                                 || ranges.translucent_sections[section_index + 1] > ranges.translucent_sections[section_index];
+                n_occluded_sections += has_quads;
+                section_index++;
+                continue;
+            }
+
+            int run_end = section_index + 1;
+            while (run_end < SECTIONS_PER_CHUNK && (sections & (1 << run_end))) {
+                run_end++;
+            }
+            size_t n_quads = ranges.opaque_sections[run_end] - ranges.opaque_sections[section_index];
+            if (n_quads > 0) {
+                opaque_render_queue.push_back(section_call(ranges.first_quad + ranges.opaque_sections[section_index], n_quads));
+            }
+            section_index = run_end;
+        }
+
+        // the translucent quads follow the opaque ones in the chunk's range, see ChunkMeshData
+        size_t first_translucent_quad = ranges.first_quad + ranges.opaque_sections[SECTIONS_PER_CHUNK];
+        for (int section : section_order) {
+            size_t n_quads = ranges.translucent_sections[section + 1] - ranges.translucent_sections[section];
+            if ((sections & (1 << section)) && n_quads > 0) {
+                translucent_render_queue.push_back(section_call(first_translucent_quad + ranges.translucent_sections[section], n_quads));
+            }
+        }
+    }
+
+    culling_stats.drawn = n_kept;
+    culling_stats.culled = render_queue.size() - n_kept;
+}
+
+// Orders render calls by the horizontal distance from the camera to the center of their chunk, nearest first. Calls
+// of the same chunk keep their order
+static void sort_by_distance(std::vector<RenderCall>& render_calls, glm::vec3 camera_pos) {
+    auto distance_squared = [camera_pos](const RenderCall& render_call) {
+        glm::vec2 offset = glm::vec2(render_call.origin) + glm::vec2(CHUNK_LENGTH, CHUNK_WIDTH) * 0.5f - glm::vec2(camera_pos);
+        return glm::dot(offset, offset);
+    };
+
+    std::stable_sort(render_calls.begin(), render_calls.end(), [&distance_squared](const RenderCall& a, const RenderCall& b) {
+        return distance_squared(a) < distance_squared(b);
+    });
+}
+
 // TODO: add layers
 void ClientApplication::render() {
     glViewport(0, 0, width, height);
-    glUseProgram(voxel_shader);
-    Shader::set_uniform(voxel_shader, "view", camera_system->view());
-    Shader::set_uniform(voxel_shader, "projection", camera_system->projection());
-    Shader::set_uniform(voxel_shader, "cameraPos", camera_system->camera_position());
-    Shader::set_uniform(voxel_shader, "renderRadius", static_cast<float>(chunk_radius * CHUNK_LENGTH));
-    Shader::set_uniform(voxel_shader, "depthMap", (int)shadow_map->get_unit());
-    Shader::set_uniform(voxel_shader, "lightPos", shadow_map->light_pos);
-
-    for (const RenderCall& render_call : render_queue) {
-        glUseProgram(render_call.shader_id);
-        Shader::set_uniform(render_call.shader_id, "textureId", (int)render_call.texture_unit);
-        Shader::set_uniform(render_call.shader_id, "model", render_call.transform);
-
-        glBindVertexArray(render_call.VAO);
-        glDrawArrays(GL_TRIANGLES, 0, render_call.n_vertices);
+    voxel_shader.use();
+    voxel_shader.set(voxel_uniforms.view, camera_system->view());
+    voxel_shader.set(voxel_uniforms.projection, camera_system->projection());
+    voxel_shader.set(voxel_uniforms.camera_pos, camera_system->camera_position());
+    // the fog is at the edge of the far terrain, which continues the chunks up to far_radius
+    float render_radius = static_cast<float>(far_radius * CHUNK_LENGTH);
+    voxel_shader.set(voxel_uniforms.render_radius, render_radius);
+    voxel_shader.set(voxel_uniforms.depth_map, (int)shadow_map->get_unit());
+    voxel_shader.set(voxel_uniforms.light_pos, shadow_map->light_pos);
+
+    // every chunk uses the voxel shader and the block textures, so the whole queue is a single multi-draw
+    if (!render_queue.empty()) {
+        voxel_shader.set(voxel_uniforms.texture_id, (int)render_queue.front().texture_unit);
+    }
+
+    // opaque quads front to back without blending, so that early depth testing rejects most hidden fragments
+    sort_by_distance(opaque_render_queue, camera_system->camera_position());
+    glDisable(GL_BLEND);
+    draw_buffer.clear();
+    for (const RenderCall& render_call : opaque_render_queue) {
+        draw_buffer.add(render_call);
+    }
+    draw_buffer.draw();
+
+    far_terrain->draw(camera_system->view(), camera_system->projection(), camera_system->camera_position(),
+                      render_radius, shadow_map->light_pos, block_texture_unit);
+
+    // translucent quads back to front over everything opaque. The ChunkManager keeps the quads of each section
+    // sorted and cull_render_queue orders the sections of each chunk, so only the chunks are ordered here. They are
+    // depth tested but do not write depth, so they never hide each other
+    voxel_shader.use();
+    sort_by_distance(translucent_render_queue, camera_system->camera_position());
+    glEnable(GL_BLEND);
+    glDepthMask(GL_FALSE);
+    draw_buffer.clear();
+    for (auto it = translucent_render_queue.rbegin(); it != translucent_render_queue.rend(); it++) {
+        draw_buffer.add(*it);
     }
+    draw_buffer.draw();
+    glDepthMask(GL_TRUE);
 }
 
 // TODO: save data to disk
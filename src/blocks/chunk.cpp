@@ -1,8 +1,12 @@
 #include "blocks/chunk.hpp"
 
 #include "blocks/common.hpp"
+#include "blocks/padded_chunk.hpp"
 #include "glm/gtc/noise.hpp"
+#include "utils/assert.hpp"
 #include "utils/logger.hpp"
+
+#include <algorithm>
 #include <array>
 
 bool Block::is_transparent(Block block) {
@@ -15,8 +19,10 @@ bool Block::is_transparent(Block block) {
 VoxelQuad::VoxelQuad(VoxelQuad::Face face, int x, int y, int z, Block::Type block_type, glm::ivec4 ao_state)
     : face(face), chunk_pos(x, y, z), block_type(block_type), ao_state(ao_state) {}
 
-Chunk::Chunk(glm::ivec2 chunk_coords, int seed)
-    : chunk_coords(chunk_coords), seed(seed), blocks(BLOCKS_PER_CHUNK, {Block::Type::AIR}) {};
+Chunk::Chunk(glm::ivec2 chunk_coords, int seed) : chunk_coords(chunk_coords), seed(seed) {
+    // nothing is known about the blocks yet, so nothing may be culled through this chunk
+    section_visibility.fill(SectionVisibility::all_connected());
+}
 
 glm::vec3 Chunk::to_world_pos(glm::vec3 chunk_pos) const {
     return { static_cast<float>(chunk_coords.x * CHUNK_LENGTH) + chunk_pos.x,
@@ -34,19 +40,36 @@ glm::vec3 Chunk::to_chunk_pos(glm::vec3 world_pos) {
     return glm::mod(world_pos, { CHUNK_LENGTH, CHUNK_WIDTH, CHUNK_HEIGHT });
 }
 
-size_t Chunk::to_block_index(glm::vec3 world_pos) const {
-    glm::ivec3 chunk_pos = glm::floor(Chunk::to_chunk_pos(world_pos));
-    return CHUNK_LENGTH * CHUNK_WIDTH * chunk_pos.z + CHUNK_LENGTH * chunk_pos.y + chunk_pos.x;
+Block Chunk::get_block(glm::ivec3 chunk_pos) const {
+    return sections[chunk_pos.z / SECTION_HEIGHT].get_block({ chunk_pos.x, chunk_pos.y, chunk_pos.z % SECTION_HEIGHT });
 }
 
-Block& Chunk::get_block(glm::ivec3 chunk_pos) {
-    size_t index = CHUNK_LENGTH * CHUNK_WIDTH * chunk_pos.z + CHUNK_LENGTH * chunk_pos.y + chunk_pos.x;
-    return blocks[index];
+Block Chunk::get_block_copy(glm::ivec3 chunk_pos) const {
+    return sections[chunk_pos.z / SECTION_HEIGHT].get_block({ chunk_pos.x, chunk_pos.y, chunk_pos.z % SECTION_HEIGHT });
 }
 
-Block Chunk::get_block_copy(glm::ivec3 chunk_pos) const {
-    size_t index = CHUNK_LENGTH * CHUNK_WIDTH * chunk_pos.z + CHUNK_LENGTH * chunk_pos.y + chunk_pos.x;
-    return blocks[index];
+void Chunk::set_block(glm::ivec3 chunk_pos, Block block) {
+    sections[chunk_pos.z / SECTION_HEIGHT].set_block({ chunk_pos.x, chunk_pos.y, chunk_pos.z % SECTION_HEIGHT }, block);
+}
+
+const ChunkSection& Chunk::get_section(int section_index) const {
+    return sections[section_index];
+}
+
+AABB Chunk::get_world_bounds() const {
+    int min_section = 0;
+    while (min_section < SECTIONS_PER_CHUNK - 1 && sections[min_section].is_empty()) {
+        min_section++;
+    }
+    int max_section = SECTIONS_PER_CHUNK - 1;
+    while (max_section > min_section && sections[max_section].is_empty()) {
+        max_section--;
+    }
+
+    return {
+        to_world_pos(glm::vec3(0.0f, 0.0f, static_cast<float>(min_section * SECTION_HEIGHT))),
+        to_world_pos(glm::vec3(CHUNK_LENGTH, CHUNK_WIDTH, static_cast<float>((max_section + 1) * SECTION_HEIGHT))),
+    };
 }
 
 std::optional<Block> Chunk::get_block_from_world_pos(glm::vec3 world_pos,
@@ -63,351 +86,268 @@ std::optional<Block> Chunk::get_block_from_world_pos(glm::vec3 world_pos,
     return { chunk.get_block_copy(in_chunk_pos) };
 }
 
+// Based on the Amanatides & Woo ray marching algorithm http://www.cse.yorku.ca/~amana/research/grid.pdf
+// Set get_adjacent to true to get the adjacent block on the face of the hit block; useful for placing blocks
+std::optional<glm::vec3> Chunk::cast_ray(glm::vec3 position,
+                                         glm::vec3 direction,
+                                         float max_distance,
+                                         bool get_adjacent,
+                                         const std::vector<Chunk>& loaded_chunks,
+                                         const std::unordered_map<glm::ivec2, size_t>& chunk_index_map) {
+    glm::vec3 step = glm::sign(direction);
+    glm::vec3 t_delta = 1.0f / glm::abs(direction);
+    glm::vec3 voxel_pos = glm::floor(position);
+    glm::vec3 next_boundary = voxel_pos + (step + 1.0f) / 2.0f;
+    glm::vec3 t_max = (next_boundary - position) / direction;
+
+    int min_axis = t_max.x < t_max.y
+        ? (t_max.x < t_max.z ? 0 : 2)
+        : (t_max.y < t_max.z ? 1 : 2);
+    float t = 0.0f;
+
+    while (t < max_distance) {
+        glm::ivec2 chunk_pos = glm::floor(glm::vec2(voxel_pos.x / CHUNK_LENGTH, voxel_pos.y / CHUNK_WIDTH));
+        if (!chunk_index_map.contains(chunk_pos)) {
+            log_error("Raycasting accessed unloaded chunk");
+            break;
+        }
+
+        const Chunk& chunk = loaded_chunks[chunk_index_map.at(chunk_pos)];
+        glm::ivec3 in_chunk_pos = glm::floor(chunk.to_chunk_pos(voxel_pos));
+
+        // nothing to hit above or below the world, or in all-air sections, skip decoding the block
+        if (in_chunk_pos.z >= 0 && in_chunk_pos.z < CHUNK_HEIGHT
+            && !chunk.get_section(in_chunk_pos.z / SECTION_HEIGHT).is_empty()
+            && chunk.get_block(in_chunk_pos).type != Block::Type::AIR) {
+            if (get_adjacent) {
+                voxel_pos[min_axis] -= step[min_axis];
+                return voxel_pos;
+            }
+            return voxel_pos;
+        }
+
+        min_axis = t_max.x < t_max.y
+            ? (t_max.x < t_max.z ? 0 : 2)
+            : (t_max.y < t_max.z ? 1 : 2);
+
+        voxel_pos[min_axis] += step[min_axis];
+        t = t_max[min_axis];
+        t_max[min_axis] += t_delta[min_axis];
+    }
+
+    return std::nullopt;
+}
+
 void Chunk::generate_blocks_from_seed() {
     for (int i = 0; i < CHUNK_LENGTH; i++) {
         for (int j = 0; j < CHUNK_WIDTH; j++) {
-            float x = static_cast<float>(i + chunk_coords.x * CHUNK_LENGTH) / (16 * CHUNK_LENGTH);
-            float y = static_cast<float>(j + chunk_coords.y * CHUNK_WIDTH) / (16 * CHUNK_WIDTH);
-
-            // elevation noise in range [0, 0.1]
-            float elevation = 0.05f 
-                + (glm::perlin(glm::vec3(1 * x, 1 * y, static_cast<float>(seed)))
-                + 0.5f * glm::perlin(glm::vec3(2 * x, 2 * y, static_cast<float>(seed)))
-                + 0.25f * glm::perlin(glm::vec3(4 * x, 4 * y, static_cast<float>(seed)))) / (2 * 1.75f);
-
-            for (int k = 0; k < CHUNK_HEIGHT; k++) {
-                Block& block = get_block({i, j, k});
-                int ground_level = static_cast<int>((elevation + 0.3f) * CHUNK_HEIGHT);
-
-                if (k <= ground_level - 5) {
-                    block = {Block::Type::STONE};
-                } else if (k <= ground_level - 1) {
-                    block = {Block::Type::DIRT};
-                } else if (k == ground_level) {
-                    block = {Block::Type::GRASS};
-                }
+            int ground_level = get_ground_level({ i + chunk_coords.x * CHUNK_LENGTH, j + chunk_coords.y * CHUNK_WIDTH }, seed);
+
+            // blocks above ground level are already air
+            for (int k = 0; k <= ground_level && k < CHUNK_HEIGHT; k++) {
+                set_block({i, j, k}, {get_generated_block(k, ground_level)});
             }
         }
     }
 }
 
-void Chunk::convert_to_mesh(const TextureManager& texture_manager,
-                            const std::vector<Chunk>& loaded_chunks,
-                            const std::unordered_map<glm::ivec2, size_t>& chunk_index_map) {
-    quads.clear();
-    mesh.vertices.clear();
-    convert_to_quads(loaded_chunks, chunk_index_map);
+int Chunk::get_ground_level(glm::ivec2 world_column, int seed) {
+    float x = static_cast<float>(world_column.x) / (16 * CHUNK_LENGTH);
+    float y = static_cast<float>(world_column.y) / (16 * CHUNK_WIDTH);
+
+    // elevation noise in range [0, 0.1]
+    float elevation = 0.05f 
+        + (glm::perlin(glm::vec3(1 * x, 1 * y, static_cast<float>(seed)))
+        + 0.5f * glm::perlin(glm::vec3(2 * x, 2 * y, static_cast<float>(seed)))
+        + 0.25f * glm::perlin(glm::vec3(4 * x, 4 * y, static_cast<float>(seed)))) / (2 * 1.75f);
+
+    return static_cast<int>((elevation + 0.3f) * CHUNK_HEIGHT);
+}
 
-    for (const VoxelQuad& quad : quads) {
-        generate_vertex_data(quad, texture_manager);
+Block::Type Chunk::get_generated_block(int z, int ground_level) {
+    if (z <= ground_level - 5) {
+        return Block::Type::STONE;
+    } else if (z <= ground_level - 1) {
+        return Block::Type::DIRT;
+    } else if (z == ground_level) {
+        return Block::Type::GRASS;
     }
+    return Block::Type::AIR;
 }
 
-constexpr std::array<VoxelQuad::Face, 6> faces = {
-    VoxelQuad::Face::TOP,
-    VoxelQuad::Face::BOTTOM,
-    VoxelQuad::Face::LEFT,
-    VoxelQuad::Face::RIGHT,
-    VoxelQuad::Face::FRONT,
-    VoxelQuad::Face::BACK,
-};
-
-constexpr std::array<glm::vec3, 6> block_neighbors = {
-    glm::vec3{0.0f, 0.0f, 1.0f},  // TOP
-    glm::vec3{0.0f, 0.0f, -1.0f}, // BOTTOM
-    glm::vec3{-1.0f, 0.0f, 0.0f}, // LEFT
-    glm::vec3{1.0f, 0.0f, 0.0f},  // RIGHT
-    glm::vec3{0.0f, -1.0f, 0.0f}, // FRONT
-    glm::vec3{0.0f, 1.0f, 0.0f},  // BACK
-};
-
-// neighboring block positions when looking at face, in a clockwise order from the top left
-// used for ambient occlusion calculations
-constexpr std::array<std::array<glm::vec3, 8>, 6> face_neighbors = {
-    std::array<glm::vec3,8>{ // TOP
-        glm::vec3{-1.0f,  1.0f, 1.0f},
-        glm::vec3{ 0.0f,  1.0f, 1.0f},
-        glm::vec3{ 1.0f,  1.0f, 1.0f},
-        glm::vec3{ 1.0f,  0.0f, 1.0f},
-        glm::vec3{ 1.0f, -1.0f, 1.0f},
-        glm::vec3{ 0.0f, -1.0f, 1.0f},
-        glm::vec3{-1.0f, -1.0f, 1.0f},
-        glm::vec3{-1.0f,  0.0f, 1.0f},
-    },
-    std::array<glm::vec3,8>{ // BOTTOM
-        glm::vec3{-1.0f, -1.0f, -1.0f},
-        glm::vec3{ 0.0f, -1.0f, -1.0f},
-        glm::vec3{ 1.0f, -1.0f, -1.0f},
-        glm::vec3{ 1.0f,  0.0f, -1.0f},
-        glm::vec3{ 1.0f,  1.0f, -1.0f},
-        glm::vec3{ 0.0f,  1.0f, -1.0f},
-        glm::vec3{-1.0f,  1.0f, -1.0f},
-        glm::vec3{-1.0f,  0.0f, -1.0f},
-    },
-    std::array<glm::vec3,8>{ // LEFT
-        glm::vec3{-1.0f,  1.0f,  1.0f},
-        glm::vec3{-1.0f,  0.0f,  1.0f},
-        glm::vec3{-1.0f, -1.0f,  1.0f},
-        glm::vec3{-1.0f, -1.0f,  0.0f},
-        glm::vec3{-1.0f, -1.0f, -1.0f},
-        glm::vec3{-1.0f,  0.0f, -1.0f},
-        glm::vec3{-1.0f,  1.0f, -1.0f},
-        glm::vec3{-1.0f,  1.0f,  0.0f},
-    },
-    std::array<glm::vec3,8>{ // RIGHT
-        glm::vec3{1.0f, -1.0f,  1.0f},
-        glm::vec3{1.0f,  0.0f,  1.0f},
-        glm::vec3{1.0f,  1.0f,  1.0f},
-        glm::vec3{1.0f,  1.0f,  0.0f},
-        glm::vec3{1.0f,  1.0f, -1.0f},
-        glm::vec3{1.0f,  0.0f, -1.0f},
-        glm::vec3{1.0f, -1.0f, -1.0f},
-        glm::vec3{1.0f, -1.0f,  0.0f},
-    },
-    std::array<glm::vec3,8>{ // FRONT
-        glm::vec3{-1.0f, -1.0f,  1.0f},
-        glm::vec3{ 0.0f, -1.0f,  1.0f},
-        glm::vec3{ 1.0f, -1.0f,  1.0f},
-        glm::vec3{ 1.0f, -1.0f,  0.0f},
-        glm::vec3{ 1.0f, -1.0f, -1.0f},
-        glm::vec3{ 0.0f, -1.0f, -1.0f},
-        glm::vec3{-1.0f, -1.0f, -1.0f},
-        glm::vec3{-1.0f, -1.0f,  0.0f},
-    },
-    std::array<glm::vec3,8>{ // BACK
-        glm::vec3{ 1.0f, 1.0f,  1.0f},
-        glm::vec3{ 0.0f, 1.0f,  1.0f},
-        glm::vec3{-1.0f, 1.0f,  1.0f},
-        glm::vec3{-1.0f, 1.0f,  0.0f},
-        glm::vec3{-1.0f, 1.0f, -1.0f},
-        glm::vec3{ 0.0f, 1.0f, -1.0f},
-        glm::vec3{ 1.0f, 1.0f, -1.0f},
-        glm::vec3{ 1.0f, 1.0f,  0.0f},
-    },
-};
-
-// in anti_clockwise order starting from bottom left
-std::array<std::array<int, 3>, 4> corner_neighbors = {
-    std::array<int, 3>{7, 6, 5},
-    std::array<int, 3>{5, 4, 3},
-    std::array<int, 3>{3, 2, 1},
-    std::array<int, 3>{1, 0, 7},
-};
-
-void Chunk::convert_to_quads(const std::vector<Chunk>& loaded_chunks,
-                             const std::unordered_map<glm::ivec2, size_t>& chunk_index_map) {
-    for (int x = 0; x < CHUNK_LENGTH; x++) {
-        for (int y = 0; y < CHUNK_WIDTH; y++) {
-            for (int z = 0; z < CHUNK_HEIGHT; z++) {
-                const Block& block = get_block({x, y, z});
-
-                if (block.type == Block::Type::AIR) {
-                    continue;
-                }
+void Chunk::convert_to_mesh(const TextureManager& texture_manager,
+                            const std::vector<Chunk>& loaded_chunks,
+                            const std::unordered_map<glm::ivec2, size_t>& chunk_index_map,
+                            MeshingMode meshing_mode) {
+    ChunkMesher chunk_mesher;
+    PaddedChunk padded_chunk(*this, loaded_chunks, chunk_index_map);
+    set_quad_data(chunk_mesher.mesh(padded_chunk, texture_manager, meshing_mode));
+    section_visibility = compute_chunk_visibility(padded_chunk);
+}
 
-                glm::vec3 current_pos = glm::vec3(x, y, z);
-                for (VoxelQuad::Face face : faces) {
-                    glm::vec3 block_neighbor_pos = to_world_pos(current_pos + block_neighbors[face]);
-                    std::optional<Block> block_neighbor = get_block_from_world_pos(block_neighbor_pos,
-                                                                                   loaded_chunks,
-                                                                                   chunk_index_map);
-
-                    // hidden-face culling
-                    if (!block_neighbor || Block::is_transparent(*block_neighbor)) {
-                        std::array<int, 8> face_neighbor_opaque{};
-
-                        // check number of opaque blocks in neighborhood of face
-                        for (int i = 0; i < 8; i++) {
-                            glm::vec3 face_neighbor_pos = to_world_pos(current_pos + face_neighbors[face][i]);
-                            std::optional<Block> face_neighbor = get_block_from_world_pos(face_neighbor_pos,
-                                                                                          loaded_chunks,
-                                                                                          chunk_index_map);
-                            if (face_neighbor && !Block::is_transparent(*face_neighbor)) {
-                                face_neighbor_opaque[i] = 1;
-                            }
-                        }
-
-                        // calculate ambient occlusion values for quad corners
-                        glm::ivec4 ao_state{};
-                        for (int i = 0; i < 4; i++) {
-                            int side_1_opaque = face_neighbor_opaque[corner_neighbors[i][0]];
-                            int side_2_opaque = face_neighbor_opaque[corner_neighbors[i][2]];
-
-                            if (side_1_opaque + side_2_opaque == 2) {
-                                ao_state[i] = 0;
-                                continue;
-                            }
-
-                            int corner_opaque = face_neighbor_opaque[corner_neighbors[i][1]];
-
-                            ao_state[i] = 3 - (side_1_opaque + side_2_opaque + corner_opaque);
-                        }
-
-                        quads.emplace_back(face, x, y, z, block.type, ao_state);
-                    }
-                }
-            }
-        }
+bool Chunk::is_section_hidden(int section_index,
+                              const std::vector<Chunk>& loaded_chunks,
+                              const std::unordered_map<glm::ivec2, size_t>& chunk_index_map) const {
+    // faces on the top and bottom of the world are always drawn
+    if (section_index == 0 || section_index == SECTIONS_PER_CHUNK - 1) {
+        return false;
     }
-}
 
-constexpr std::array<float, 4> ao_values = { 0.512f, 0.64f, 0.8f, 1.0f };
-
-void Chunk::generate_vertex_data(const VoxelQuad& quad, const TextureManager& texture_manager) {
-    int x = quad.chunk_pos.x;
-    int y = quad.chunk_pos.y;
-    int z = quad.chunk_pos.z;
-    int texture_index{};
-    glm::ivec4 ao = quad.ao_state;
-
-    // TODO: refactor out vertex offsets
-    switch (quad.face) {
-        case VoxelQuad::Face::TOP:
-            texture_index = texture_manager.get_texture_index(quad.block_type, VoxelQuad::Face::TOP);
-            // have split in quad across from the darkest corner
-            if (ao_values[ao[0]] + ao_values[ao[2]] > ao_values[ao[1]] + ao_values[ao[3]]) {
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 1, 0, 0, texture_index, VoxelQuad::Face::TOP, ao[0]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 1, 1, 0, texture_index, VoxelQuad::Face::TOP, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 1, 1, 1, texture_index, VoxelQuad::Face::TOP, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 1, 1, 1, texture_index, VoxelQuad::Face::TOP, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 1, 0, 1, texture_index, VoxelQuad::Face::TOP, ao[3]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 1, 0, 0, texture_index, VoxelQuad::Face::TOP, ao[0]}.pack_data());
-            } else {
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 1, 0, 0, texture_index, VoxelQuad::Face::TOP, ao[0]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 1, 1, 0, texture_index, VoxelQuad::Face::TOP, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 1, 0, 1, texture_index, VoxelQuad::Face::TOP, ao[3]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 1, 1, 0, texture_index, VoxelQuad::Face::TOP, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 1, 1, 1, texture_index, VoxelQuad::Face::TOP, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 1, 0, 1, texture_index, VoxelQuad::Face::TOP, ao[3]}.pack_data());
+    if (!sections[section_index].is_opaque()
+        || !sections[section_index - 1].is_opaque()
+        || !sections[section_index + 1].is_opaque()) {
+        return false;
+    }
 
-            }
-            break;
-        case VoxelQuad::Face::BOTTOM:
-            texture_index = texture_manager.get_texture_index(quad.block_type, VoxelQuad::Face::BOTTOM);
-            if (ao_values[ao[0]] + ao_values[ao[2]] > ao_values[ao[1]] + ao_values[ao[3]]) {
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 0, 0, 0, texture_index, VoxelQuad::Face::BOTTOM, ao[0]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 0, 1, 0, texture_index, VoxelQuad::Face::BOTTOM, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 0, 1, 1, texture_index, VoxelQuad::Face::BOTTOM, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 0, 1, 1, texture_index, VoxelQuad::Face::BOTTOM, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 0, 0, 1, texture_index, VoxelQuad::Face::BOTTOM, ao[3]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 0, 0, 0, texture_index, VoxelQuad::Face::BOTTOM, ao[0]}.pack_data());
-            } else {
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 0, 0, 0, texture_index, VoxelQuad::Face::BOTTOM, ao[0]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 0, 1, 0, texture_index, VoxelQuad::Face::BOTTOM, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 0, 0, 1, texture_index, VoxelQuad::Face::BOTTOM, ao[3]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 0, 1, 0, texture_index, VoxelQuad::Face::BOTTOM, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 0, 1, 1, texture_index, VoxelQuad::Face::BOTTOM, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 0, 0, 1, texture_index, VoxelQuad::Face::BOTTOM, ao[3]}.pack_data());
-            }
-            break;
-        case VoxelQuad::Face::LEFT:
-            texture_index = texture_manager.get_texture_index(quad.block_type, VoxelQuad::Face::LEFT);
-            if (ao_values[ao[0]] + ao_values[ao[2]] > ao_values[ao[1]] + ao_values[ao[3]]) {
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 0, 0, 0, texture_index, VoxelQuad::Face::LEFT, ao[0]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 0, 1, 0, texture_index, VoxelQuad::Face::LEFT, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 1, 1, 1, texture_index, VoxelQuad::Face::LEFT, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 1, 1, 1, texture_index, VoxelQuad::Face::LEFT, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 1, 0, 1, texture_index, VoxelQuad::Face::LEFT, ao[3]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 0, 0, 0, texture_index, VoxelQuad::Face::LEFT, ao[0]}.pack_data());
-            } else {
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 0, 0, 0, texture_index, VoxelQuad::Face::LEFT, ao[0]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 0, 1, 0, texture_index, VoxelQuad::Face::LEFT, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 1, 0, 1, texture_index, VoxelQuad::Face::LEFT, ao[3]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 0, 1, 0, texture_index, VoxelQuad::Face::LEFT, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 1, 1, 1, texture_index, VoxelQuad::Face::LEFT, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 1, 0, 1, texture_index, VoxelQuad::Face::LEFT, ao[3]}.pack_data());
-            }
-            break;
-        case VoxelQuad::Face::RIGHT:
-            texture_index = texture_manager.get_texture_index(quad.block_type, VoxelQuad::Face::RIGHT);
-            if (ao_values[ao[0]] + ao_values[ao[2]] > ao_values[ao[1]] + ao_values[ao[3]]) {
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 0, 0, 0, texture_index, VoxelQuad::Face::RIGHT, ao[0]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 0, 1, 0, texture_index, VoxelQuad::Face::RIGHT, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 1, 1, 1, texture_index, VoxelQuad::Face::RIGHT, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 1, 1, 1, texture_index, VoxelQuad::Face::RIGHT, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 1, 0, 1, texture_index, VoxelQuad::Face::RIGHT, ao[3]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 0, 0, 0, texture_index, VoxelQuad::Face::RIGHT, ao[0]}.pack_data());
-            } else {
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 0, 0, 0, texture_index, VoxelQuad::Face::RIGHT, ao[0]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 0, 1, 0, texture_index, VoxelQuad::Face::RIGHT, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 1, 0, 1, texture_index, VoxelQuad::Face::RIGHT, ao[3]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 0, 1, 0, texture_index, VoxelQuad::Face::RIGHT, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 1, 1, 1, texture_index, VoxelQuad::Face::RIGHT, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 1, 0, 1, texture_index, VoxelQuad::Face::RIGHT, ao[3]}.pack_data());
-            }
-            break;
-        case VoxelQuad::Face::FRONT:
-            texture_index = texture_manager.get_texture_index(quad.block_type, VoxelQuad::Face::FRONT);
-            if (ao_values[ao[0]] + ao_values[ao[2]] > ao_values[ao[1]] + ao_values[ao[3]]) {
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 0, 0, 0, texture_index, VoxelQuad::Face::FRONT, ao[0]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 0, 1, 0, texture_index, VoxelQuad::Face::FRONT, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 1, 1, 1, texture_index, VoxelQuad::Face::FRONT, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 1, 1, 1, texture_index, VoxelQuad::Face::FRONT, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 1, 0, 1, texture_index, VoxelQuad::Face::FRONT, ao[3]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 0, 0, 0, texture_index, VoxelQuad::Face::FRONT, ao[0]}.pack_data());
-            } else {
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 0, 0, 0, texture_index, VoxelQuad::Face::FRONT, ao[0]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 0, 1, 0, texture_index, VoxelQuad::Face::FRONT, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 1, 0, 1, texture_index, VoxelQuad::Face::FRONT, ao[3]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 0, 1, 0, texture_index, VoxelQuad::Face::FRONT, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 0, z + 1, 1, 1, texture_index, VoxelQuad::Face::FRONT, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 0, z + 1, 0, 1, texture_index, VoxelQuad::Face::FRONT, ao[3]}.pack_data());
-            }
-            break;
-        case VoxelQuad::Face::BACK:
-            texture_index = texture_manager.get_texture_index(quad.block_type, VoxelQuad::Face::BACK);
-            if (ao_values[ao[0]] + ao_values[ao[2]] > ao_values[ao[1]] + ao_values[ao[3]]) {
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 0, 0, 0, texture_index, VoxelQuad::Face::BACK, ao[0]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 0, 1, 0, texture_index, VoxelQuad::Face::BACK, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 1, 1, 1, texture_index, VoxelQuad::Face::BACK, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 1, 1, 1, texture_index, VoxelQuad::Face::BACK, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 1, 0, 1, texture_index, VoxelQuad::Face::BACK, ao[3]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 0, 0, 0, texture_index, VoxelQuad::Face::BACK, ao[0]}.pack_data());
-            } else {
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 0, 0, 0, texture_index, VoxelQuad::Face::BACK, ao[0]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 0, 1, 0, texture_index, VoxelQuad::Face::BACK, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 1, 0, 1, texture_index, VoxelQuad::Face::BACK, ao[3]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 0, 1, 0, texture_index, VoxelQuad::Face::BACK, ao[1]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 0, y + 1, z + 1, 1, 1, texture_index, VoxelQuad::Face::BACK, ao[2]}.pack_data());
-                mesh.vertices.push_back(Vertex{x + 1, y + 1, z + 1, 0, 1, texture_index, VoxelQuad::Face::BACK, ao[3]}.pack_data());
-            }
-            break;
+    constexpr std::array<glm::ivec2, 4> chunk_neighbors = {
+        glm::ivec2{-1, 0},
+        glm::ivec2{1, 0},
+        glm::ivec2{0, -1},
+        glm::ivec2{0, 1},
+    };
+
+    for (glm::ivec2 offset : chunk_neighbors) {
+        auto it = chunk_index_map.find(chunk_coords + offset);
+        if (it == chunk_index_map.end()
+            || loaded_chunks[it->second].get_lod() < lod
+            || !loaded_chunks[it->second].get_section(section_index).is_opaque()) {
+            return false;
+        }
     }
+
+    return true;
 }
 
 GLuint Chunk::get_VAO() const {
     return mesh.VAO;
 }
 
-size_t Chunk::get_num_vertices() const {
-    return mesh.vertices.size();
+size_t Chunk::get_num_quads() const {
+    return mesh.quad_data.size() / QUAD_RECORD_WORDS;
+}
+
+size_t Chunk::get_num_opaque_quads() const {
+    return mesh.n_opaque_quads;
+}
+
+size_t Chunk::get_num_translucent_quads() const {
+    return get_num_quads() - mesh.n_opaque_quads;
+}
+
+const SectionQuadOffsets& Chunk::get_opaque_sections() const {
+    return mesh.opaque_sections;
+}
+
+const SectionQuadOffsets& Chunk::get_translucent_sections() const {
+    return mesh.translucent_sections;
 }
 
 glm::ivec2 Chunk::get_chunk_coords() const {
     return chunk_coords;
 }
 
-const std::vector<uint32_t>& Chunk::get_vertices() const {
-    return mesh.vertices;
+int Chunk::get_seed() const {
+    return seed;
+}
+
+const std::vector<uint32_t>& Chunk::get_quad_data() const {
+    return mesh.quad_data;
+}
+
+void Chunk::set_quad_data(ChunkMeshData mesh_data) {
+    mesh.quad_data = std::move(mesh_data.quad_data);
+    mesh.n_opaque_quads = mesh_data.n_opaque_quads;
+    mesh.opaque_sections = mesh_data.opaque_sections;
+    mesh.translucent_sections = mesh_data.translucent_sections;
+}
+
+void Chunk::set_translucent_quad_data(const std::vector<uint32_t>& quad_data) {
+    debug_assert(quad_data.size() == get_num_translucent_quads() * QUAD_RECORD_WORDS,
+                 "Sorted translucent quads do not match the mesh");
+    std::copy(quad_data.begin(), quad_data.end(), mesh.quad_data.begin() + mesh.n_opaque_quads * QUAD_RECORD_WORDS);
+}
+
+const ChunkVisibility& Chunk::get_section_visibility() const {
+    return section_visibility;
+}
+
+void Chunk::set_section_visibility(const ChunkVisibility& visibility) {
+    section_visibility = visibility;
+}
+
+int Chunk::get_lod() const {
+    return lod;
+}
+
+void Chunk::set_lod(int lod) {
+    this->lod = lod;
 }
 
+// The block vector is in z-major order regardless of the storage layout
 void Chunk::set_blocks(std::vector<Block> blocks) {
-    this->blocks = std::move(blocks);
+    if (blocks.size() != BLOCKS_PER_CHUNK) {
+        log_error("Chunk (%d, %d) received %zu blocks", chunk_coords.x, chunk_coords.y, blocks.size());
+        return;
+    }
+
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        ChunkSection& section = sections[section_index];
+        auto begin = blocks.begin() + section_index * BLOCKS_PER_SECTION;
+        auto end = begin + BLOCKS_PER_SECTION;
+
+        // uniform sections (all air above ground, all stone deep below) are filled in one go
+        Block first = *begin;
+        if (std::all_of(begin, end, [first](Block block) { return block.type == first.type; })) {
+            section.fill(first);
+            continue;
+        }
+
+        section.fill({ Block::Type::AIR });
+        for (int z = 0; z < SECTION_HEIGHT; z++) {
+            for (int y = 0; y < CHUNK_WIDTH; y++) {
+                for (int x = 0; x < CHUNK_LENGTH; x++) {
+                    section.set_block({ x, y, z }, begin[LinearLayout::index(x, y, z)]);
+                }
+            }
+        }
+    }
 }
 
 std::vector<Block> Chunk::get_blocks() const {
-    return this->blocks;
+    std::vector<Block> result(BLOCKS_PER_CHUNK, { Block::Type::AIR });
+
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        const ChunkSection& section = sections[section_index];
+        if (section.is_empty()) {
+            continue;
+        }
+
+        auto begin = result.begin() + section_index * BLOCKS_PER_SECTION;
+        const PaletteStorage& storage = section.get_storage();
+        if (storage.get_bits_per_index() == 0) {
+            std::fill(begin, begin + BLOCKS_PER_SECTION, Block{ storage.get_palette()[0] });
+            continue;
+        }
+
+        for (int z = 0; z < SECTION_HEIGHT; z++) {
+            for (int y = 0; y < CHUNK_WIDTH; y++) {
+                for (int x = 0; x < CHUNK_LENGTH; x++) {
+                    begin[LinearLayout::index(x, y, z)] = section.get_block({ x, y, z });
+                }
+            }
+        }
+    }
+    return result;
 }
 
 void Chunk::add_block(glm::vec3 world_pos, Block block) {
-    size_t index = to_block_index(world_pos);
-    blocks[index] = block;
-    log_debug("Adding block %d", blocks[index].type);
+    glm::ivec3 chunk_pos = glm::floor(Chunk::to_chunk_pos(world_pos));
+    set_block(chunk_pos, block);
+    log_debug("Adding block %d", get_block(chunk_pos).type);
 }
 
 void Chunk::delete_block(glm::vec3 world_pos) {
-    size_t index = to_block_index(world_pos);
-    log_debug("Deleting block %d", blocks[index].type);
-    blocks[index] = { Block::Type::AIR };
+    glm::ivec3 chunk_pos = glm::floor(Chunk::to_chunk_pos(world_pos));
+    log_debug("Deleting block %d", get_block(chunk_pos).type);
+    set_block(chunk_pos, { Block::Type::AIR });
 }
-
@@ -0,0 +1,324 @@
+#include "blocks/chunk_codec.hpp"
+
+#include "blocks/block_layout.hpp"
+#include "utils/assert.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+// palette size, palette and a one block run per block of every section
+constexpr size_t MAX_BODY_SIZE = SECTIONS_PER_CHUNK * (1 + Block::Type::SIZE + BLOCKS_PER_SECTION);
+
+std::vector<std::byte> encode_chunk_blocks(const std::vector<Block>& blocks, bool compress) {
+    debug_assert(blocks.size() == BLOCKS_PER_CHUNK, "Encoded chunks must have BLOCKS_PER_CHUNK blocks");
+
+    std::vector<std::byte> body;
+    body.reserve(2 * SECTIONS_PER_CHUNK);
+
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        int section_base = section_index * SECTION_HEIGHT;
+        auto type_at = [&blocks, section_base](int x, int y, int z) {
+            return blocks[LinearLayout::index(x, y, section_base + z)].type;
+        };
+
+        // palette in order of first appearance, so that encoding the same blocks always gives the same bytes
+        std::array<int, Block::Type::SIZE> palette_indices;
+        palette_indices.fill(-1);
+        std::vector<Block::Type> palette;
+        for (int z = 0; z < SECTION_HEIGHT; z++) {
+            for (int y = 0; y < CHUNK_WIDTH; y++) {
+                for (int x = 0; x < CHUNK_LENGTH; x++) {
+                    Block::Type type = type_at(x, y, z);
+                    debug_assert(type >= 0 && type < Block::Type::SIZE, "Encoded block has an invalid type");
+                    if (palette_indices[type] < 0) {
+                        palette_indices[type] = static_cast<int>(palette.size());
+                        palette.push_back(type);
+                    }
+                }
+            }
+        }
+
+        body.push_back(static_cast<std::byte>(palette.size()));
+        for (Block::Type type : palette) {
+            body.push_back(static_cast<std::byte>(type));
+        }
+        if (palette.size() == 1) {
+            continue;
+        }
+
+        for (int y = 0; y < CHUNK_WIDTH; y++) {
+            for (int x = 0; x < CHUNK_LENGTH; x++) {
+                int run_start = 0;
+                for (int z = 1; z <= SECTION_HEIGHT; z++) {
+                    if (z < SECTION_HEIGHT && type_at(x, y, z) == type_at(x, y, run_start)) {
+                        continue;
+                    }
+
+                    int palette_index = palette_indices[type_at(x, y, run_start)];
+                    body.push_back(static_cast<std::byte>(palette_index << 4 | (z - run_start - 1)));
+                    run_start = z;
+                }
+            }
+        }
+    }
+
+    std::vector<std::byte> encoded = { static_cast<std::byte>(CHUNK_ENCODING_VERSION), std::byte{ 0 } };
+
+    if (compress) {
+        std::vector<std::byte> compressed = lz_compress(body);
+        uint32_t body_size = static_cast<uint32_t>(body.size());
+        if (compressed.size() + sizeof(body_size) < body.size()) {
+            encoded[1] |= static_cast<std::byte>(CHUNK_ENCODING_LZ);
+            encoded.resize(encoded.size() + sizeof(body_size));
+            std::memcpy(encoded.data() + 2, &body_size, sizeof(body_size));
+            encoded.insert(encoded.end(), compressed.begin(), compressed.end());
+            return encoded;
+        }
+    }
+
+    encoded.insert(encoded.end(), body.begin(), body.end());
+    return encoded;
+}
+
+std::optional<std::vector<Block>> decode_chunk_blocks(const std::byte* data, size_t size) {
+    if (size < 2) {
+        return std::nullopt;
+    }
+
+    uint8_t version = static_cast<uint8_t>(data[0]);
+    uint8_t flags = static_cast<uint8_t>(data[1]);
+    if (version != CHUNK_ENCODING_VERSION || (flags & ~CHUNK_ENCODING_LZ) != 0) {
+        return std::nullopt;
+    }
+
+    const std::byte* body = data + 2;
+    size_t body_size = size - 2;
+
+    std::optional<std::vector<std::byte>> decompressed;
+    if (flags & CHUNK_ENCODING_LZ) {
+        uint32_t raw_size{};
+        if (body_size < sizeof(raw_size)) {
+            return std::nullopt;
+        }
+        std::memcpy(&raw_size, body, sizeof(raw_size));
+        if (raw_size > MAX_BODY_SIZE) {
+            return std::nullopt;
+        }
+
+        decompressed = lz_decompress(body + sizeof(raw_size), body_size - sizeof(raw_size), raw_size);
+        if (!decompressed) {
+            return std::nullopt;
+        }
+        body = decompressed->data();
+        body_size = decompressed->size();
+    }
+
+    std::vector<Block> blocks(BLOCKS_PER_CHUNK);
+    size_t pos = 0;
+
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        if (pos >= body_size) {
+            return std::nullopt;
+        }
+        size_t palette_size = static_cast<size_t>(body[pos++]);
+        if (palette_size == 0 || palette_size > Block::Type::SIZE || palette_size > body_size - pos) {
+            return std::nullopt;
+        }
+
+        std::array<Block::Type, Block::Type::SIZE> palette{};
+        for (size_t i = 0; i < palette_size; i++) {
+            uint8_t type = static_cast<uint8_t>(body[pos++]);
+            if (type >= Block::Type::SIZE) {
+                return std::nullopt;
+            }
+            palette[i] = static_cast<Block::Type>(type);
+        }
+
+        int section_base = section_index * SECTION_HEIGHT;
+
+        // sections are contiguous in z-major order
+        if (palette_size == 1) {
+            auto begin = blocks.begin() + LinearLayout::index(0, 0, section_base);
+            std::fill(begin, begin + BLOCKS_PER_SECTION, Block{ palette[0] });
+            continue;
+        }
+
+        for (int y = 0; y < CHUNK_WIDTH; y++) {
+            for (int x = 0; x < CHUNK_LENGTH; x++) {
+                int z = 0;
+                while (z < SECTION_HEIGHT) {
+                    if (pos >= body_size) {
+                        return std::nullopt;
+                    }
+                    uint8_t run = static_cast<uint8_t>(body[pos++]);
+                    size_t palette_index = run >> 4;
+                    int length = (run & 0xF) + 1;
+                    if (palette_index >= palette_size || z + length > SECTION_HEIGHT) {
+                        return std::nullopt;
+                    }
+
+                    for (int i = 0; i < length; i++) {
+                        blocks[LinearLayout::index(x, y, section_base + z + i)] = { palette[palette_index] };
+                    }
+                    z += length;
+                }
+            }
+        }
+    }
+
+    if (pos != body_size) {
+        return std::nullopt;
+    }
+    return blocks;
+}
+
+// LZ sequences: a token byte with the literal count in the high nibble and the match length minus LZ_MIN_MATCH in
+// the low nibble, a nibble of 15 meaning that the rest of the value follows as bytes of 255 ended by a smaller byte.
+// Then the literals, the 2 byte little endian offset of the match and the rest of the match length. The last
+// sequence has no match and ends the data.
+constexpr size_t LZ_MIN_MATCH = 4;
+constexpr size_t LZ_MAX_OFFSET = 65535;
+constexpr int LZ_HASH_BITS = 12;
+
+static uint32_t read_u32(const std::byte* data) {
+    uint32_t value{};
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Fibonacci hashing of the next 4 bytes
+static uint32_t lz_hash(uint32_t value) {
+    return (value * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static void write_length(std::vector<std::byte>& output, size_t length) {
+    for (; length >= 255; length -= 255) {
+        output.push_back(std::byte{ 255 });
+    }
+    output.push_back(static_cast<std::byte>(length));
+}
+
+// A match_length of 0 writes the last sequence
+static void write_sequence(std::vector<std::byte>& output, const std::byte* literals, size_t n_literals,
+                           size_t offset, size_t match_length) {
+    size_t match_code = match_length > 0 ? match_length - LZ_MIN_MATCH : 0;
+    output.push_back(static_cast<std::byte>(std::min<size_t>(n_literals, 15) << 4 | std::min<size_t>(match_code, 15)));
+    if (n_literals >= 15) {
+        write_length(output, n_literals - 15);
+    }
+    output.insert(output.end(), literals, literals + n_literals);
+
+    if (match_length == 0) {
+        return;
+    }
+    output.push_back(static_cast<std::byte>(offset & 0xFF));
+    output.push_back(static_cast<std::byte>(offset >> 8));
+    if (match_code >= 15) {
+        write_length(output, match_code - 15);
+    }
+}
+
+// Greedy parse: the last position of each hash is the only match candidate
+std::vector<std::byte> lz_compress(const std::vector<std::byte>& input) {
+    const std::byte* data = input.data();
+    size_t size = input.size();
+
+    std::vector<std::byte> output;
+    output.reserve(size / 2 + 16);
+    std::vector<int64_t> last_positions(size_t{ 1 } << LZ_HASH_BITS, -1);
+
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (pos + LZ_MIN_MATCH <= size) {
+        uint32_t hash = lz_hash(read_u32(data + pos));
+        int64_t candidate = last_positions[hash];
+        last_positions[hash] = static_cast<int64_t>(pos);
+
+        if (candidate < 0 || pos - candidate > LZ_MAX_OFFSET || read_u32(data + candidate) != read_u32(data + pos)) {
+            pos++;
+            continue;
+        }
+
+        size_t length = LZ_MIN_MATCH;
+        while (pos + length < size && data[candidate + length] == data[pos + length]) {
+            length++;
+        }
+        write_sequence(output, data + anchor, pos - anchor, pos - candidate, length);
+
+        // positions inside the match are indexed too, so that the next repeat of them can be found
+        for (size_t i = pos + 1; i < pos + length && i + LZ_MIN_MATCH <= size; i++) {
+            last_positions[lz_hash(read_u32(data + i))] = static_cast<int64_t>(i);
+        }
+        pos += length;
+        anchor = pos;
+    }
+
+    write_sequence(output, data + anchor, size - anchor, 0, 0);
+    return output;
+}
+
+std::optional<std::vector<std::byte>> lz_decompress(const std::byte* data, size_t size, size_t raw_size) {
+    std::vector<std::byte> output(raw_size);
+    size_t output_pos = 0;
+    size_t pos = 0;
+
+    auto read_length = [&](size_t& length) {
+        while (pos < size) {
+            uint8_t value = static_cast<uint8_t>(data[pos++]);
+            length += value;
+            if (value != 255) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    while (true) {
+        if (pos >= size) {
+            return std::nullopt;
+        }
+        uint8_t token = static_cast<uint8_t>(data[pos++]);
+
+        size_t n_literals = token >> 4;
+        if (n_literals == 15 && !read_length(n_literals)) {
+            return std::nullopt;
+        }
+        if (n_literals > size - pos || n_literals > raw_size - output_pos) {
+            return std::nullopt;
+        }
+        std::memcpy(output.data() + output_pos, data + pos, n_literals);
+        pos += n_literals;
+        output_pos += n_literals;
+
+        if (pos == size) {
+            break;
+        }
+
+        if (size - pos < 2) {
+            return std::nullopt;
+        }
+        size_t offset = static_cast<size_t>(data[pos]) | static_cast<size_t>(data[pos + 1]) << 8;
+        pos += 2;
+
+        size_t length = token & 0xF;
+        if (length == 15 && !read_length(length)) {
+            return std::nullopt;
+        }
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > output_pos || length > raw_size - output_pos) {
+            return std::nullopt;
+        }
+
+        // byte by byte, since a match may overlap the bytes it produces
+        for (size_t i = 0; i < length; i++) {
+            output[output_pos + i] = output[output_pos - offset + i];
+        }
+        output_pos += length;
+    }
+
+    if (output_pos != raw_size) {
+        return std::nullopt;
+    }
+    return output;
+}
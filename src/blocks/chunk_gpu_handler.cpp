@@ -1,55 +1,166 @@
 #include "blocks/chunk_gpu_handler.hpp"
 #include "blocks/chunk.hpp"
+#include "utils/assert.hpp"
 #include "utils/logger.hpp"
 
+#include <algorithm>
+
+ChunkGPUHandler::~ChunkGPUHandler() {
+    if (VAO) {
+        glDeleteBuffers(1, &EBO);
+        glDeleteBuffers(1, &SSBO);
+        glDeleteVertexArrays(1, &VAO);
+    }
+}
+
 void ChunkGPUHandler::allocate_chunk(glm::ivec2 chunk_coords) {
-    if (chunk_buffers_map.contains(chunk_coords)) {
+    if (chunk_ranges.contains(chunk_coords)) {
         return;
     }
-    Buffers buffers{};
-
-    glGenVertexArrays(1, &buffers.VAO);
-    glBindVertexArray(buffers.VAO);
-    glGenBuffers(1, &buffers.VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, buffers.VBO);
 
-    glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, 0, (void*)0);
-    glEnableVertexAttribArray(0);
-    glBufferData(GL_ARRAY_BUFFER, BLOCKS_PER_CHUNK * VERTICES_PER_BLOCK * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+    // the buffer is created on first use so that the handler can be constructed before the GL context
+    if (!VAO) {
+        create_buffer();
+    }
 
-    chunk_buffers_map.insert({ chunk_coords, buffers });
+    // empty until the chunk is meshed, so drawing it draws nothing
+    chunk_ranges.insert({ chunk_coords, BufferRange{} });
 }
 
 void ChunkGPUHandler::deallocate_chunk(glm::ivec2 chunk_coords) {
-    if (!chunk_buffers_map.contains(chunk_coords)) {
+    auto it = chunk_ranges.find(chunk_coords);
+    if (it == chunk_ranges.end()) {
+        return;
+    }
+
+    allocator.free(it->second);
+    chunk_ranges.erase(it);
+}
+
+void ChunkGPUHandler::send_mesh_to_gpu(glm::ivec2 chunk_coords, const std::vector<uint32_t>& quad_data) {
+    allocate_chunk(chunk_coords);
+    BufferRange& range = chunk_ranges.at(chunk_coords);
+
+    // free first so that the old range can be reused if the mesh still fits
+    allocator.free(range);
+    range = {};
+
+    if (quad_data.empty()) {
         return;
     }
-    Buffers buffers = chunk_buffers_map.at(chunk_coords);
+    size_t n_quads = quad_data.size() / QUAD_RECORD_WORDS;
+    reserve_indices(n_quads);
 
-    glBindVertexArray(0);
-    glDeleteBuffers(1, &buffers.VBO);
-    glDeleteVertexArrays(1, &buffers.VAO);
+    size_t size = (n_quads + ALLOCATION_GRANULARITY - 1) / ALLOCATION_GRANULARITY * ALLOCATION_GRANULARITY;
+    std::optional<BufferRange> new_range = allocator.allocate(size);
+    if (!new_range) {
+        grow_buffer(allocator.get_capacity() + size);
+        new_range = allocator.allocate(size);
+    }
+    range = *new_range;
 
-    chunk_buffers_map.erase(chunk_coords);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, range.offset * QUAD_SIZE, quad_data.size() * sizeof(uint32_t), quad_data.data());
 }
 
-void ChunkGPUHandler::send_mesh_to_gpu(glm::ivec2 chunk_coords, const std::vector<uint32_t>& vertices) {
-    if (!chunk_buffers_map.contains(chunk_coords)) {
-        allocate_chunk(chunk_coords);
+void ChunkGPUHandler::update_quads(glm::ivec2 chunk_coords, size_t first_quad, const std::vector<uint32_t>& quad_data) {
+    auto it = chunk_ranges.find(chunk_coords);
+    if (it == chunk_ranges.end()) {
+        log_error("Chunk (%d, %d) is not allocated on the GPU", chunk_coords.x, chunk_coords.y);
         return;
     }
-    Buffers buffers = chunk_buffers_map.at(chunk_coords);
+    debug_assert(first_quad + quad_data.size() / QUAD_RECORD_WORDS <= it->second.size, "Quad update overflows the chunk's range");
 
-    glBindVertexArray(buffers.VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, buffers.VBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(uint32_t), vertices.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, (it->second.offset + first_quad) * QUAD_SIZE,
+                    quad_data.size() * sizeof(uint32_t), quad_data.data());
 }
 
 GLuint ChunkGPUHandler::get_chunk_VAO(glm::ivec2 chunk_coords) const {
-    if (!chunk_buffers_map.contains(chunk_coords)) {
+    if (!chunk_ranges.contains(chunk_coords)) {
         log_error("Chunk (%d, %d) is not allocated on the GPU", chunk_coords.x, chunk_coords.y);
         return 0;
     }
 
-    return chunk_buffers_map.at(chunk_coords).VAO;
+    return VAO;
+}
+
+size_t ChunkGPUHandler::get_chunk_first_quad(glm::ivec2 chunk_coords) const {
+    auto it = chunk_ranges.find(chunk_coords);
+    if (it == chunk_ranges.end()) {
+        log_error("Chunk (%d, %d) is not allocated on the GPU", chunk_coords.x, chunk_coords.y);
+        return 0;
+    }
+
+    return it->second.offset;
+}
+
+BufferAllocatorStats ChunkGPUHandler::get_stats() const {
+    return allocator.get_stats();
+}
+
+void ChunkGPUHandler::create_buffer() {
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+
+    // the storage buffer binding is global state rather than part of the VAO, so it stays bound for every draw
+    glGenBuffers(1, &SSBO);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, INITIAL_CAPACITY * QUAD_SIZE, nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, QUAD_BUFFER_BINDING, SSBO);
+
+    // the element buffer binding is part of the VAO
+    glGenBuffers(1, &EBO);
+    reserve_indices(INITIAL_INDEXED_QUADS);
+
+    allocator = BufferAllocator(INITIAL_CAPACITY);
+}
+
+// Makes the index buffer cover at least n_quads quads, doubling its size when it has to grow
+void ChunkGPUHandler::reserve_indices(size_t n_quads) {
+    if (n_quads <= n_indexed_quads) {
+        return;
+    }
+
+    size_t new_n_quads = std::max(n_indexed_quads, INITIAL_INDEXED_QUADS);
+    while (new_n_quads < n_quads) {
+        new_n_quads *= 2;
+    }
+
+    std::vector<uint32_t> indices;
+    indices.reserve(new_n_quads * INDICES_PER_QUAD);
+    for (size_t quad = 0; quad < new_n_quads; quad++) {
+        for (uint32_t index : QUAD_INDICES) {
+            indices.push_back(static_cast<uint32_t>(quad * VERTICES_PER_QUAD) + index);
+        }
+    }
+
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+    n_indexed_quads = new_n_quads;
+}
+
+// Doubles the buffer until it holds min_capacity quads, copying the existing meshes over
+void ChunkGPUHandler::grow_buffer(size_t min_capacity) {
+    size_t old_capacity = allocator.get_capacity();
+    size_t new_capacity = old_capacity;
+    while (new_capacity < min_capacity) {
+        new_capacity *= 2;
+    }
+
+    GLuint new_SSBO{};
+    glGenBuffers(1, &new_SSBO);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, new_SSBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, new_capacity * QUAD_SIZE, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, SSBO);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, old_capacity * QUAD_SIZE);
+    glDeleteBuffers(1, &SSBO);
+    SSBO = new_SSBO;
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, QUAD_BUFFER_BINDING, SSBO);
+
+    allocator.grow(new_capacity);
+    log_debug("Grew chunk quad buffer from %zu to %zu KiB", old_capacity * QUAD_SIZE / 1024, new_capacity * QUAD_SIZE / 1024);
 }
@@ -2,8 +2,12 @@
 
 #include "utils/logger.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <cstring>
+#include <optional>
+#include <utility>
 #include <vector>
 
 ChunkManager::ChunkManager(int seed, int chunk_radius) : seed(seed), chunk_radius(chunk_radius) {}
@@ -65,31 +69,31 @@ void ChunkManager::update(glm::vec3 player_pos) {
             // remesh corner/neighboring chunks if blocks modified on chunk boundary
             glm::ivec3 in_chunk_pos = glm::floor(Chunk::to_chunk_pos(block_pos));
             if (in_chunk_pos.x == 0 && in_chunk_pos.y == 0) {
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(0, -1));
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(-1, -1));
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(-1, 0));
+                remesh_chunk(chunk_pos + glm::ivec2(0, -1));
+                remesh_chunk(chunk_pos + glm::ivec2(-1, -1));
+                remesh_chunk(chunk_pos + glm::ivec2(-1, 0));
             } else if (in_chunk_pos.x == 0 && in_chunk_pos.y == CHUNK_WIDTH - 1) {
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(-1, 0));
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(-1, 1));
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(0, 1));
+                remesh_chunk(chunk_pos + glm::ivec2(-1, 0));
+                remesh_chunk(chunk_pos + glm::ivec2(-1, 1));
+                remesh_chunk(chunk_pos + glm::ivec2(0, 1));
             } else if (in_chunk_pos.x == CHUNK_LENGTH - 1 && in_chunk_pos.y == CHUNK_WIDTH - 1) {
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(0, 1));
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(1, 1));
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(1, 0));
+                remesh_chunk(chunk_pos + glm::ivec2(0, 1));
+                remesh_chunk(chunk_pos + glm::ivec2(1, 1));
+                remesh_chunk(chunk_pos + glm::ivec2(1, 0));
             } else if (in_chunk_pos.x == CHUNK_LENGTH - 1 && in_chunk_pos.y == 0) {
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(1, 0));
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(1, -1));
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(0, -1));
+                remesh_chunk(chunk_pos + glm::ivec2(1, 0));
+                remesh_chunk(chunk_pos + glm::ivec2(1, -1));
+                remesh_chunk(chunk_pos + glm::ivec2(0, -1));
             } else if (in_chunk_pos.x == 0) {
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(-1, 0));
+                remesh_chunk(chunk_pos + glm::ivec2(-1, 0));
             } else if (in_chunk_pos.y == CHUNK_WIDTH - 1) {
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(0, 1));
+                remesh_chunk(chunk_pos + glm::ivec2(0, 1));
             } else if (in_chunk_pos.x == CHUNK_LENGTH - 1) {
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(1, 0));
+                remesh_chunk(chunk_pos + glm::ivec2(1, 0));
             } else if (in_chunk_pos.y == 0) {
-                mesh_chunk_queue.push(chunk_pos + glm::ivec2(0, -1));
+                remesh_chunk(chunk_pos + glm::ivec2(0, -1));
             }
-            mesh_chunk_queue.push(chunk_pos);
+            remesh_chunk(chunk_pos);
         }
     }
 }
@@ -105,10 +109,32 @@ void ChunkManager::request_all_chunks(ClientInterface& client) {
     }
 };
 
+void ChunkManager::generate_requested_chunks() {
+    while (!request_chunk_queue.empty()) {
+        glm::ivec2 chunk_pos = request_chunk_queue.front();
+        request_chunk_queue.pop();
+
+        Chunk chunk(chunk_pos, seed);
+        chunk.generate_blocks_from_seed();
+        received_chunk_queue.push(ChunkData{ chunk_pos, seed, chunk.get_blocks() });
+    }
+}
+
 // Deserialize chunk data received from the server and queue chunk data to be loaded
 void ChunkManager::receive_chunk_data(Packet packet) {
-    ChunkData chunk_data = ChunkData::deserialize(packet);
-    received_chunk_queue.push(std::move(chunk_data));
+    std::optional<ChunkData> chunk_data = ChunkData::deserialize(packet);
+    if (!chunk_data.has_value()) {
+        // once the chunk leaves the request set, the next update requests it again
+        std::optional<glm::ivec2> chunk_pos = ChunkData::read_chunk_coords(packet);
+        if (chunk_pos.has_value()) {
+            log_error("Chunk (%d, %d) data could not be decoded, requesting it again", chunk_pos->x, chunk_pos->y);
+            request_chunk_queue_set.erase(*chunk_pos);
+        } else {
+            log_error("Dropping a chunk packet that is too short");
+        }
+        return;
+    }
+    received_chunk_queue.push(std::move(*chunk_data));
 }
 
 // Generates num_chunks Chunk objects and load their blocks
@@ -125,6 +151,7 @@ void ChunkManager::load_chunks(int num_chunks) {
         // generate Chunk object from ChunkData
         Chunk current_chunk(chunk_data.chunk_coords, chunk_data.seed);
         current_chunk.set_blocks(std::move(chunk_data.blocks));
+        current_chunk.set_lod(get_lod(chunk_pos));
 
         // add to loaded chunks list and finally remove from request_chunk_queue_set since we have processed the chuck
         size_t current_index = loaded_chunks.size();
@@ -132,11 +159,11 @@ void ChunkManager::load_chunks(int num_chunks) {
         chunk_index_map.insert({chunk_pos, current_index});
         request_chunk_queue_set.erase(chunk_pos);
 
-        mesh_chunk_queue.push(chunk_pos + glm::ivec2(-1, 0));
-        mesh_chunk_queue.push(chunk_pos + glm::ivec2(1, 0));
-        mesh_chunk_queue.push(chunk_pos + glm::ivec2(0, -1));
-        mesh_chunk_queue.push(chunk_pos + glm::ivec2(0, 1));
-        mesh_chunk_queue.push(chunk_pos);
+        remesh_chunk(chunk_pos + glm::ivec2(-1, 0));
+        remesh_chunk(chunk_pos + glm::ivec2(1, 0));
+        remesh_chunk(chunk_pos + glm::ivec2(0, -1));
+        remesh_chunk(chunk_pos + glm::ivec2(0, 1));
+        remesh_chunk(chunk_pos);
 
         // allocate GPU buffers first since we may attempt to draw these chunks before they are meshed and sent to the GPU.
         // thus, we will only draw nothing and not a non-existent VAO
@@ -154,6 +181,7 @@ void ChunkManager::load_all_chunks() {
         // generate Chunk object from ChunkData
         Chunk current_chunk(chunk_data.chunk_coords, chunk_data.seed);
         current_chunk.set_blocks(std::move(chunk_data.blocks));
+        current_chunk.set_lod(get_lod(chunk_pos));
 
         // add to loaded chunks list and finally remove from request_chunk_queue_set since we have processed the chuck
         size_t current_index = loaded_chunks.size();
@@ -161,11 +189,11 @@ void ChunkManager::load_all_chunks() {
         chunk_index_map.insert({chunk_pos, current_index});
         request_chunk_queue_set.erase(chunk_pos);
 
-        mesh_chunk_queue.push(chunk_pos + glm::ivec2(-1, 0));
-        mesh_chunk_queue.push(chunk_pos + glm::ivec2(1, 0));
-        mesh_chunk_queue.push(chunk_pos + glm::ivec2(0, -1));
-        mesh_chunk_queue.push(chunk_pos + glm::ivec2(0, 1));
-        mesh_chunk_queue.push(chunk_pos);
+        remesh_chunk(chunk_pos + glm::ivec2(-1, 0));
+        remesh_chunk(chunk_pos + glm::ivec2(1, 0));
+        remesh_chunk(chunk_pos + glm::ivec2(0, -1));
+        remesh_chunk(chunk_pos + glm::ivec2(0, 1));
+        remesh_chunk(chunk_pos);
 
         // allocate GPU buffers first since we may attempt to draw these chunks before they are meshed and sent to the GPU.
         // thus, we will only draw nothing and not a non-existent VAO
@@ -173,6 +201,12 @@ void ChunkManager::load_all_chunks() {
     }
 }
 
+// The whole column is used since the old mesh of a changed chunk may have been taller than the new one
+static AABB chunk_column_bounds(glm::ivec2 chunk_pos) {
+    glm::vec3 min(chunk_pos.x * CHUNK_LENGTH, chunk_pos.y * CHUNK_WIDTH, 0.0f);
+    return { min, min + glm::vec3(CHUNK_LENGTH, CHUNK_WIDTH, CHUNK_HEIGHT) };
+}
+
 // Unloads a Chunk object and deletes it from the GPU
 void ChunkManager::unload_chunks(int num_chunks) {
     for (int i = 0; i < num_chunks; i++) {
@@ -186,11 +220,16 @@ void ChunkManager::unload_chunks(int num_chunks) {
 
         debug_assert(chunk_index_map.contains(chunk_pos), "Unloading non-existent chunk");
         size_t chunk_index = chunk_index_map.at(chunk_pos);
+        invalidate_mesh(chunk_pos);
+        dirty_chunks.erase(chunk_pos);
+        sort_versions.erase(chunk_pos);
+        changed_mesh_bounds.push_back(chunk_column_bounds(chunk_pos));
 
         // skip swapping to end to remove if chunk is already at the end: causes double erase and segfaults
         if (chunk_index == loaded_chunks.size() - 1) {
             loaded_chunks.pop_back();
             chunk_index_map.erase(chunk_pos);
+            chunk_gpu_handler.deallocate_chunk(chunk_pos);
             continue;
         }
 
@@ -206,94 +245,290 @@ void ChunkManager::unload_chunks(int num_chunks) {
     }
 }
 
-// Creates the mesh of num_chunks Chunks from their loaded blocks, then sends the meshes to the GPU
-void ChunkManager::mesh_chunks(int num_chunks, TextureManager& texture_manager) {
-    for (int i = 0; i < num_chunks; i++) {
-        if (mesh_chunk_queue.empty()) {
-            break;
+void ChunkManager::set_view(glm::vec3 camera_position, const glm::mat4& view_projection) {
+    this->camera_position = camera_position;
+    view_frustum = Frustum(view_projection);
+    update_lods();
+    find_visible_sections(camera_position, view_frustum, loaded_chunks, chunk_index_map, visible_sections);
+
+    // the back to front order of the quads only needs to be redone when the camera crosses a block boundary
+    glm::ivec3 camera_block = glm::floor(camera_position);
+    if (camera_block != sort_camera_block) {
+        sort_camera_block = camera_block;
+        for (const Chunk& chunk : loaded_chunks) {
+            submit_sort_job(chunk.get_chunk_coords());
         }
+    }
+}
 
-        glm::ivec2 chunk_pos = mesh_chunk_queue.front();
-        mesh_chunk_queue.pop();
+uint16_t ChunkManager::get_visible_sections(glm::ivec2 chunk_coords) const {
+    auto it = chunk_index_map.find(chunk_coords);
+    if (it == chunk_index_map.end() || it->second >= visible_sections.size()) {
+        return UINT16_MAX;
+    }
 
-        if (!chunk_index_map.contains(chunk_pos)) {
-            continue;
-        }
+    return visible_sections[it->second];
+}
 
-        Chunk& chunk = loaded_chunks[chunk_index_map.at(chunk_pos)];
-        chunk.convert_to_mesh(texture_manager, loaded_chunks, chunk_index_map);
+// Uploads meshes finished by the worker pool, then snapshots the num_chunks most important dirty Chunks to be meshed
+void ChunkManager::mesh_chunks(int num_chunks, TextureManager& texture_manager) {
+    upload_sort_results();
+    upload_mesh_results();
 
-        chunk_gpu_handler.send_mesh_to_gpu(chunk_pos, chunk.get_vertices());
+    for (glm::ivec2 chunk_pos : take_dirty_chunks(num_chunks)) {
+        submit_mesh_job(chunk_pos, texture_manager);
     }
 }
 
-// Creates the mesh of all Chunks in the queue from their loaded blocks, then sends the meshes to the GPU
+static const char* meshing_mode_name(MeshingMode mode) {
+    switch (mode) {
+        case MeshingMode::PerFace:
+            return "per-face";
+        case MeshingMode::Greedy:
+            return "greedy";
+        case MeshingMode::Binary:
+            return "binary";
+    }
+    return "unknown";
+}
+
+// Meshes all Chunks in the queue on the worker pool and waits for their meshes to be sent to the GPU
 void ChunkManager::mesh_all_chunks(TextureManager& texture_manager) {
-    while (!mesh_chunk_queue.empty()) {
-        glm::ivec2 chunk_pos = mesh_chunk_queue.front();
-        mesh_chunk_queue.pop();
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (glm::ivec2 chunk_pos : take_dirty_chunks(dirty_chunks.size())) {
+        submit_mesh_job(chunk_pos, texture_manager);
+    }
+
+    mesh_worker_pool.wait_idle();
+    int n_meshed = upload_mesh_results();
+
+    size_t n_quads = 0;
+    for (const Chunk& chunk : loaded_chunks) {
+        n_quads += chunk.get_num_quads();
+    }
+
+    // reported per block layout and meshing mode so they can be compared, see blocks/block_layout.hpp
+    float elapsed_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+    log_debug("Meshed %d chunks in %.2f ms on %d threads (%zu quads loaded, %s mesher, %s block layout)",
+              n_meshed, elapsed_ms, mesh_worker_pool.get_num_threads(), n_quads,
+              meshing_mode_name(meshing_mode), BLOCK_LAYOUT_NAME);
+    log_debug("Remesh requests: %zu, coalesced: %zu, submitted: %zu, cancelled: %zu, wasted: %zu, uploaded: %zu",
+              mesh_stats.requested, mesh_stats.coalesced, mesh_stats.submitted,
+              mesh_stats.cancelled, mesh_stats.wasted, mesh_stats.uploaded);
+
+    BufferAllocatorStats buffer_stats = chunk_gpu_handler.get_stats();
+    log_debug("Chunk vertex buffer: %zu of %zu KiB used by %zu meshes, %zu free ranges, largest %zu KiB",
+              buffer_stats.used * ChunkGPUHandler::QUAD_SIZE / 1024,
+              buffer_stats.capacity * ChunkGPUHandler::QUAD_SIZE / 1024, buffer_stats.n_allocations,
+              buffer_stats.n_free_ranges, buffer_stats.largest_free_range * ChunkGPUHandler::QUAD_SIZE / 1024);
+}
+
+const MeshStats& ChunkManager::get_mesh_stats() const {
+    return mesh_stats;
+}
+
+std::vector<AABB> ChunkManager::take_changed_mesh_bounds() {
+    return std::exchange(changed_mesh_bounds, {});
+}
+
+void ChunkManager::set_meshing_mode(MeshingMode mode) {
+    meshing_mode = mode;
+
+    for (const Chunk& chunk : loaded_chunks) {
+        remesh_chunk(chunk.get_chunk_coords());
+    }
+}
 
-        if (!chunk_index_map.contains(chunk_pos)) {
+MeshingMode ChunkManager::get_meshing_mode() const {
+    return meshing_mode;
+}
+
+void ChunkManager::remesh_chunk(glm::ivec2 chunk_pos) {
+    if (!chunk_index_map.contains(chunk_pos)) {
+        return;
+    }
+
+    invalidate_mesh(chunk_pos);
+    mesh_stats.requested++;
+    if (!dirty_chunks.insert(chunk_pos).second) {
+        mesh_stats.coalesced++;
+    }
+}
+
+// Level of detail for a chunk at the current camera position
+int ChunkManager::get_lod(glm::ivec2 chunk_pos) const {
+    glm::ivec2 camera_chunk = glm::floor(glm::vec2(camera_position.x / CHUNK_LENGTH, camera_position.y / CHUNK_WIDTH));
+    int dist = glm::floor(glm::length(glm::vec2(chunk_pos - camera_chunk)));
+
+    int lod = 0;
+    while (lod < MAX_LOD && dist >= LOD_DISTANCES[lod]) {
+        lod++;
+    }
+    return lod;
+}
+
+// Neighbors are remeshed too since whether they keep their faces on the shared side depends on both levels
+void ChunkManager::update_lods() {
+    for (Chunk& chunk : loaded_chunks) {
+        glm::ivec2 chunk_pos = chunk.get_chunk_coords();
+        int lod = get_lod(chunk_pos);
+        if (lod == chunk.get_lod()) {
             continue;
         }
 
-        Chunk& chunk = loaded_chunks[chunk_index_map.at(chunk_pos)];
-        chunk.convert_to_mesh(texture_manager, loaded_chunks, chunk_index_map);
+        chunk.set_lod(lod);
+        remesh_chunk(chunk_pos + glm::ivec2(-1, 0));
+        remesh_chunk(chunk_pos + glm::ivec2(1, 0));
+        remesh_chunk(chunk_pos + glm::ivec2(0, -1));
+        remesh_chunk(chunk_pos + glm::ivec2(0, 1));
+        remesh_chunk(chunk_pos);
+    }
+}
 
-        chunk_gpu_handler.send_mesh_to_gpu(chunk_pos, chunk.get_vertices());
+// Any result of a job submitted before this call will be dropped
+void ChunkManager::invalidate_mesh(glm::ivec2 chunk_pos) {
+    if (mesh_versions.erase(chunk_pos) > 0) {
+        mesh_stats.cancelled += mesh_worker_pool.cancel(chunk_pos);
     }
 }
 
-std::vector<Chunk>& ChunkManager::get_chunks() {
-    return loaded_chunks;
+// Removes and returns up to max_chunks dirty chunks, those in the view frustum first and then the nearest ones
+std::vector<glm::ivec2> ChunkManager::take_dirty_chunks(size_t max_chunks) {
+    struct Candidate {
+        glm::ivec2 chunk_pos;
+        bool visible;
+        float distance_squared;
+    };
+
+    std::vector<Candidate> candidates;
+    candidates.reserve(dirty_chunks.size());
+
+    for (glm::ivec2 chunk_pos : dirty_chunks) {
+        glm::vec3 min(chunk_pos.x * CHUNK_LENGTH, chunk_pos.y * CHUNK_WIDTH, 0.0f);
+        glm::vec3 max = min + glm::vec3(CHUNK_LENGTH, CHUNK_WIDTH, CHUNK_HEIGHT);
+        glm::vec2 offset = glm::vec2(min + max) * 0.5f - glm::vec2(camera_position);
+
+        candidates.push_back({ chunk_pos, view_frustum.intersects_aabb(min, max), glm::dot(offset, offset) });
+    }
+
+    size_t n_taken = std::min(max_chunks, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + n_taken, candidates.end(),
+                      [](const Candidate& a, const Candidate& b) {
+                          if (a.visible != b.visible) {
+                              return a.visible;
+                          }
+                          return a.distance_squared < b.distance_squared;
+                      });
+
+    std::vector<glm::ivec2> taken;
+    taken.reserve(n_taken);
+    for (size_t i = 0; i < n_taken; i++) {
+        taken.push_back(candidates[i].chunk_pos);
+        dirty_chunks.erase(candidates[i].chunk_pos);
+    }
+
+    return taken;
 }
 
-GLuint ChunkManager::get_chunk_VAO(glm::ivec2 chunk_coords) const {
-    return chunk_gpu_handler.get_chunk_VAO(chunk_coords);
+// Snapshots the chunk and its neighbors on this thread; the worker only reads the snapshot
+void ChunkManager::submit_mesh_job(glm::ivec2 chunk_pos, const TextureManager& texture_manager) {
+    uint64_t version = next_mesh_version++;
+    mesh_versions[chunk_pos] = version;
+
+    const Chunk& chunk = loaded_chunks[chunk_index_map.at(chunk_pos)];
+    mesh_worker_pool.submit(MeshJob{
+        chunk_pos,
+        version,
+        PaddedChunk(chunk, loaded_chunks, chunk_index_map),
+        &texture_manager,
+        meshing_mode,
+    });
+    mesh_stats.submitted++;
 }
 
-// Based on the Amanatides & Woo ray marching algorithm http://www.cse.yorku.ca/~amana/research/grid.pdf
-// Set get_adjacent to true to get the adjacent block on the face of the hit block; useful for placing blocks
-std::optional<glm::vec3> ChunkManager::cast_ray(glm::vec3 position, glm::vec3 direction, bool get_adjacent) {
-    glm::vec3 step = glm::sign(direction);
-    glm::vec3 t_delta = 1.0f / glm::abs(direction);
-    glm::vec3 voxel_pos = glm::floor(position);
-    glm::vec3 next_boundary = voxel_pos + (step + 1.0f) / 2.0f;
-    glm::vec3 t_max = (next_boundary - position) / direction;
-
-    int min_axis = t_max.x < t_max.y
-        ? (t_max.x < t_max.z ? 0 : 2)
-        : (t_max.y < t_max.z ? 1 : 2);
-    float t = 0.0f;
-
-    while (t < 10.0f) {
-        glm::ivec2 chunk_pos = glm::floor(glm::vec2(voxel_pos.x / CHUNK_LENGTH, voxel_pos.y / CHUNK_WIDTH));
-        if (!chunk_index_map.contains(chunk_pos)) {
-            log_error("Raycasting accessed unloaded chunk");
-            break;
+// Sends finished meshes to the GPU, skipping results of chunks that were edited, remeshed or unloaded since
+// their job was submitted. Returns the number of meshes uploaded
+int ChunkManager::upload_mesh_results() {
+    int n_uploaded = 0;
+
+    for (MeshResult& result : mesh_worker_pool.take_results()) {
+        auto it = mesh_versions.find(result.chunk_coords);
+        if (it == mesh_versions.end() || it->second != result.version || !chunk_index_map.contains(result.chunk_coords)) {
+            mesh_stats.wasted++;
+            continue;
         }
+        mesh_versions.erase(it);
+
+        Chunk& chunk = loaded_chunks[chunk_index_map.at(result.chunk_coords)];
+        chunk.set_quad_data(std::move(result.mesh_data));
+        chunk.set_section_visibility(result.section_visibility);
+        chunk_gpu_handler.send_mesh_to_gpu(result.chunk_coords, chunk.get_quad_data());
+        changed_mesh_bounds.push_back(chunk_column_bounds(result.chunk_coords));
+        // the translucent quads come out of the mesher in block order, and any sort in flight is for the old mesh
+        submit_sort_job(result.chunk_coords);
+        n_uploaded++;
+        mesh_stats.uploaded++;
+    }
 
-        Chunk& chunk = loaded_chunks[chunk_index_map.at(chunk_pos)];
-        Block hit_block = chunk.get_block(chunk.to_chunk_pos(voxel_pos));
+    return n_uploaded;
+}
 
-        if (hit_block.type != Block::Type::AIR) {
-            if (get_adjacent) {
-                voxel_pos[min_axis] -= step[min_axis];
-                return voxel_pos;
-            }
-            return voxel_pos;
-        }
+// Copies the chunk's translucent quads to be sorted for the camera's current block. Any result of an earlier sort
+// job of the chunk will be dropped
+void ChunkManager::submit_sort_job(glm::ivec2 chunk_pos) {
+    sort_versions.erase(chunk_pos);
 
-        min_axis = t_max.x < t_max.y
-            ? (t_max.x < t_max.z ? 0 : 2)
-            : (t_max.y < t_max.z ? 1 : 2);
+    const Chunk& chunk = loaded_chunks[chunk_index_map.at(chunk_pos)];
+    if (chunk.get_num_translucent_quads() == 0) {
+        return;
+    }
 
-        voxel_pos[min_axis] += step[min_axis];
-        t = t_max[min_axis];
-        t_max[min_axis] += t_delta[min_axis];
+    uint64_t version = next_sort_version++;
+    sort_versions[chunk_pos] = version;
+
+    const std::vector<uint32_t>& quad_data = chunk.get_quad_data();
+    glm::vec3 camera_block_center = glm::floor(camera_position) + 0.5f;
+    translucency_sorter.submit(SortJob{
+        chunk_pos,
+        version,
+        camera_block_center - chunk.to_world_pos(glm::vec3(0.0f)),
+        std::vector<uint32_t>(quad_data.begin() + chunk.get_num_opaque_quads() * QUAD_RECORD_WORDS, quad_data.end()),
+        chunk.get_translucent_sections(),
+    });
+}
+
+// Writes the sorted translucent quads over the chunk's current ones, skipping results of chunks that were remeshed,
+// re-sorted or unloaded since their job was submitted
+void ChunkManager::upload_sort_results() {
+    for (SortResult& result : translucency_sorter.take_results()) {
+        auto it = sort_versions.find(result.chunk_coords);
+        if (it == sort_versions.end() || it->second != result.version) {
+            continue;
+        }
+        sort_versions.erase(it);
+
+        Chunk& chunk = loaded_chunks[chunk_index_map.at(result.chunk_coords)];
+        chunk.set_translucent_quad_data(result.quad_data);
+        chunk_gpu_handler.update_quads(result.chunk_coords, chunk.get_num_opaque_quads(), result.quad_data);
     }
+}
 
-    return std::nullopt;
+std::vector<Chunk>& ChunkManager::get_chunks() {
+    return loaded_chunks;
+}
+
+GLuint ChunkManager::get_chunk_VAO(glm::ivec2 chunk_coords) const {
+    return chunk_gpu_handler.get_chunk_VAO(chunk_coords);
+}
+
+size_t ChunkManager::get_chunk_first_quad(glm::ivec2 chunk_coords) const {
+    return chunk_gpu_handler.get_chunk_first_quad(chunk_coords);
+}
+
+// Blocks can be reached up to 10 blocks away
+std::optional<glm::vec3> ChunkManager::cast_ray(glm::vec3 position, glm::vec3 direction, bool get_adjacent) {
+    return Chunk::cast_ray(position, direction, 10.0f, get_adjacent, loaded_chunks, chunk_index_map);
 }
 
 void ChunkManager::add_event(Event event) {
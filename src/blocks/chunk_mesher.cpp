@@ -0,0 +1,465 @@
+#include "blocks/chunk_mesher.hpp"
+
+#include "blocks/padded_chunk.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+ChunkMeshData ChunkMesher::mesh(const PaddedChunk& padded_chunk,
+                                const TextureManager& texture_manager,
+                                MeshingMode meshing_mode) {
+    mesh_data.clear();
+    build_quads(padded_chunk, meshing_mode);
+
+    // opaque quads first, then by section. Stable so that every section keeps the order the mesher produced its
+    // quads in
+    auto group_of = [](const VoxelQuad& quad) {
+        int section_index = quad.chunk_pos.z / SECTION_HEIGHT;
+        return Block::is_transparent({ quad.block_type }) ? SECTIONS_PER_CHUNK + section_index : section_index;
+    };
+    std::stable_sort(quads.begin(), quads.end(), [&group_of](const VoxelQuad& a, const VoxelQuad& b) {
+        return group_of(a) < group_of(b);
+    });
+
+    std::array<uint32_t, 2 * SECTIONS_PER_CHUNK + 1> group_offsets{};
+    for (const VoxelQuad& quad : quads) {
+        group_offsets[group_of(quad) + 1]++;
+        generate_quad_record(quad, texture_manager);
+    }
+    for (size_t i = 1; i < group_offsets.size(); i++) {
+        group_offsets[i] += group_offsets[i - 1];
+    }
+
+    ChunkMeshData mesh{ std::move(mesh_data), group_offsets[SECTIONS_PER_CHUNK] };
+    for (int i = 0; i <= SECTIONS_PER_CHUNK; i++) {
+        mesh.opaque_sections[i] = group_offsets[i];
+        mesh.translucent_sections[i] = group_offsets[SECTIONS_PER_CHUNK + i] - group_offsets[SECTIONS_PER_CHUNK];
+    }
+    return mesh;
+}
+
+size_t ChunkMesher::count_quads(const PaddedChunk& padded_chunk, MeshingMode meshing_mode) {
+    build_quads(padded_chunk, meshing_mode);
+    return quads.size();
+}
+
+void ChunkMesher::build_quads(const PaddedChunk& padded_chunk, MeshingMode meshing_mode) {
+    quads.clear();
+
+    switch (meshing_mode) {
+        case MeshingMode::PerFace:
+            convert_to_quads(padded_chunk);
+            break;
+        case MeshingMode::Greedy:
+            convert_to_quads(padded_chunk);
+            merge_quads();
+            break;
+        case MeshingMode::Binary:
+            convert_to_quads_binary(padded_chunk);
+            break;
+    }
+}
+
+constexpr std::array<VoxelQuad::Face, 6> faces = {
+    VoxelQuad::Face::TOP,
+    VoxelQuad::Face::BOTTOM,
+    VoxelQuad::Face::LEFT,
+    VoxelQuad::Face::RIGHT,
+    VoxelQuad::Face::FRONT,
+    VoxelQuad::Face::BACK,
+};
+
+constexpr std::array<glm::ivec3, 6> block_neighbors = {
+    glm::ivec3{ 0,  0,  1}, // TOP
+    glm::ivec3{ 0,  0, -1}, // BOTTOM
+    glm::ivec3{-1,  0,  0}, // LEFT
+    glm::ivec3{ 1,  0,  0}, // RIGHT
+    glm::ivec3{ 0, -1,  0}, // FRONT
+    glm::ivec3{ 0,  1,  0}, // BACK
+};
+
+// neighboring block positions when looking at face, in a clockwise order from the top left
+// used for ambient occlusion calculations
+constexpr std::array<std::array<glm::ivec3, 8>, 6> face_neighbors = {
+    std::array<glm::ivec3,8>{ // TOP
+        glm::ivec3{-1,  1,  1},
+        glm::ivec3{ 0,  1,  1},
+        glm::ivec3{ 1,  1,  1},
+        glm::ivec3{ 1,  0,  1},
+        glm::ivec3{ 1, -1,  1},
+        glm::ivec3{ 0, -1,  1},
+        glm::ivec3{-1, -1,  1},
+        glm::ivec3{-1,  0,  1},
+    },
+    std::array<glm::ivec3,8>{ // BOTTOM
+        glm::ivec3{-1, -1, -1},
+        glm::ivec3{ 0, -1, -1},
+        glm::ivec3{ 1, -1, -1},
+        glm::ivec3{ 1,  0, -1},
+        glm::ivec3{ 1,  1, -1},
+        glm::ivec3{ 0,  1, -1},
+        glm::ivec3{-1,  1, -1},
+        glm::ivec3{-1,  0, -1},
+    },
+    std::array<glm::ivec3,8>{ // LEFT
+        glm::ivec3{-1,  1,  1},
+        glm::ivec3{-1,  0,  1},
+        glm::ivec3{-1, -1,  1},
+        glm::ivec3{-1, -1,  0},
+        glm::ivec3{-1, -1, -1},
+        glm::ivec3{-1,  0, -1},
+        glm::ivec3{-1,  1, -1},
+        glm::ivec3{-1,  1,  0},
+    },
+    std::array<glm::ivec3,8>{ // RIGHT
+        glm::ivec3{ 1, -1,  1},
+        glm::ivec3{ 1,  0,  1},
+        glm::ivec3{ 1,  1,  1},
+        glm::ivec3{ 1,  1,  0},
+        glm::ivec3{ 1,  1, -1},
+        glm::ivec3{ 1,  0, -1},
+        glm::ivec3{ 1, -1, -1},
+        glm::ivec3{ 1, -1,  0},
+    },
+    std::array<glm::ivec3,8>{ // FRONT
+        glm::ivec3{-1, -1,  1},
+        glm::ivec3{ 0, -1,  1},
+        glm::ivec3{ 1, -1,  1},
+        glm::ivec3{ 1, -1,  0},
+        glm::ivec3{ 1, -1, -1},
+        glm::ivec3{ 0, -1, -1},
+        glm::ivec3{-1, -1, -1},
+        glm::ivec3{-1, -1,  0},
+    },
+    std::array<glm::ivec3,8>{ // BACK
+        glm::ivec3{ 1,  1,  1},
+        glm::ivec3{ 0,  1,  1},
+        glm::ivec3{-1,  1,  1},
+        glm::ivec3{-1,  1,  0},
+        glm::ivec3{-1,  1, -1},
+        glm::ivec3{ 0,  1, -1},
+        glm::ivec3{ 1,  1, -1},
+        glm::ivec3{ 1,  1,  0},
+    },
+};
+
+// in anti_clockwise order starting from bottom left
+constexpr std::array<std::array<int, 3>, 4> corner_neighbors = {
+    std::array<int, 3>{7, 6, 5},
+    std::array<int, 3>{5, 4, 3},
+    std::array<int, 3>{3, 2, 1},
+    std::array<int, 3>{1, 0, 7},
+};
+
+// calculate ambient occlusion values for quad corners from the opacity of the 8 blocks around the face
+static glm::ivec4 calculate_ao_state(const std::array<int, 8>& face_neighbor_opaque) {
+    glm::ivec4 ao_state{};
+    for (int i = 0; i < 4; i++) {
+        int side_1_opaque = face_neighbor_opaque[corner_neighbors[i][0]];
+        int side_2_opaque = face_neighbor_opaque[corner_neighbors[i][2]];
+
+        if (side_1_opaque + side_2_opaque == 2) {
+            ao_state[i] = 0;
+            continue;
+        }
+
+        int corner_opaque = face_neighbor_opaque[corner_neighbors[i][1]];
+
+        ao_state[i] = 3 - (side_1_opaque + side_2_opaque + corner_opaque);
+    }
+    return ao_state;
+}
+
+void ChunkMesher::convert_to_quads(const PaddedChunk& padded_chunk) {
+    // downsampled chunks are only seen from far away, where occlusion would just stop their faces from merging
+    bool ambient_occlusion = padded_chunk.get_lod() == 0;
+
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        if (padded_chunk.is_section_skipped(section_index)) {
+            continue;
+        }
+
+        for (int x = 0; x < CHUNK_LENGTH; x++) {
+            for (int y = 0; y < CHUNK_WIDTH; y++) {
+                for (int z = section_index * SECTION_HEIGHT; z < (section_index + 1) * SECTION_HEIGHT; z++) {
+                    Block block = padded_chunk.get_block({x, y, z});
+
+                    if (block.type == Block::Type::AIR) {
+                        continue;
+                    }
+
+                    glm::ivec3 current_pos(x, y, z);
+                    for (VoxelQuad::Face face : faces) {
+                        Block block_neighbor = padded_chunk.get_block(current_pos + block_neighbors[face]);
+
+                        // hidden-face culling, translucent blocks also hide the faces between blocks of their own type
+                        if (Block::is_transparent(block_neighbor) && block_neighbor.type != block.type) {
+                            std::array<int, 8> face_neighbor_opaque{};
+
+                            // check number of opaque blocks in neighborhood of face
+                            for (int i = 0; i < 8 && ambient_occlusion; i++) {
+                                Block face_neighbor = padded_chunk.get_block(current_pos + face_neighbors[face][i]);
+                                face_neighbor_opaque[i] = !Block::is_transparent(face_neighbor);
+                            }
+
+                            quads.emplace_back(face, x, y, z, block.type, calculate_ao_state(face_neighbor_opaque));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// axis perpendicular to each face
+constexpr std::array<int, 6> face_normal_axes = { 2, 2, 0, 0, 1, 1 };
+
+// axes spanned by each face; VoxelQuad::size is measured along these
+constexpr std::array<glm::ivec2, 6> face_plane_axes = {
+    glm::ivec2{0, 1}, // TOP
+    glm::ivec2{0, 1}, // BOTTOM
+    glm::ivec2{1, 2}, // LEFT
+    glm::ivec2{1, 2}, // RIGHT
+    glm::ivec2{0, 2}, // FRONT
+    glm::ivec2{0, 2}, // BACK
+};
+
+constexpr glm::ivec3 chunk_extent = { CHUNK_LENGTH, CHUNK_WIDTH, CHUNK_HEIGHT };
+
+// Greedy meshing: merges the 1x1 quads of each face direction and slice into as few rectangles as possible.
+// Only faces with the same block type and the same ambient occlusion value at all four corners are merged,
+// since the occlusion is interpolated across a quad and a merged quad only has four corners; all other faces
+// are kept as is. Merged quads do not cross sections, so that each quad is drawn with the section of its blocks.
+void ChunkMesher::merge_quads() {
+    // group quads by face direction, then by slice along the face normal
+    std::sort(quads.begin(), quads.end(), [](const VoxelQuad& a, const VoxelQuad& b) {
+        if (a.face != b.face) {
+            return a.face < b.face;
+        }
+        return a.chunk_pos[face_normal_axes[a.face]] < b.chunk_pos[face_normal_axes[b.face]];
+    });
+
+    std::vector<VoxelQuad> merged_quads;
+    merged_quads.reserve(quads.size());
+
+    // merge keys of one slice indexed by [v * CHUNK_LENGTH + u], -1 where there is nothing to merge
+    std::vector<int> mask(CHUNK_LENGTH * CHUNK_HEIGHT, -1);
+
+    size_t slice_begin = 0;
+    while (slice_begin < quads.size()) {
+        VoxelQuad::Face face = quads[slice_begin].face;
+        int normal_axis = face_normal_axes[face];
+        int slice = quads[slice_begin].chunk_pos[normal_axis];
+        glm::ivec2 axes = face_plane_axes[face];
+        int u_length = chunk_extent[axes.x];
+
+        size_t slice_end = slice_begin;
+        int v_min = CHUNK_HEIGHT;
+        int v_max = -1;
+        for (; slice_end < quads.size(); slice_end++) {
+            const VoxelQuad& quad = quads[slice_end];
+            if (quad.face != face || quad.chunk_pos[normal_axis] != slice) {
+                break;
+            }
+
+            glm::ivec4 ao = quad.ao_state;
+            if (ao[0] != ao[1] || ao[0] != ao[2] || ao[0] != ao[3]) {
+                merged_quads.push_back(quad);
+                continue;
+            }
+
+            int u = quad.chunk_pos[axes.x];
+            int v = quad.chunk_pos[axes.y];
+            mask[v * CHUNK_LENGTH + u] = static_cast<int>(quad.block_type) * 4 + ao[0];
+            v_min = std::min(v_min, v);
+            v_max = std::max(v_max, v);
+        }
+
+        for (int v = v_min; v <= v_max; v++) {
+            for (int u = 0; u < u_length; u++) {
+                int key = mask[v * CHUNK_LENGTH + u];
+                if (key < 0) {
+                    continue;
+                }
+
+                int width = 1;
+                while (u + width < u_length && mask[v * CHUNK_LENGTH + u + width] == key) {
+                    width++;
+                }
+
+                int height = 1;
+                for (; v + height <= v_max; height++) {
+                    // v is the height for the side faces
+                    if (axes.y == 2 && (v + height) % SECTION_HEIGHT == 0) {
+                        break;
+                    }
+                    const int* row = &mask[(v + height) * CHUNK_LENGTH + u];
+                    if (std::any_of(row, row + width, [key](int other) { return other != key; })) {
+                        break;
+                    }
+                }
+
+                for (int dv = 0; dv < height; dv++) {
+                    std::fill_n(&mask[(v + dv) * CHUNK_LENGTH + u], width, -1);
+                }
+
+                glm::ivec3 chunk_pos{};
+                chunk_pos[normal_axis] = slice;
+                chunk_pos[axes.x] = u;
+                chunk_pos[axes.y] = v;
+
+                int ao = key % 4;
+                VoxelQuad& merged_quad = merged_quads.emplace_back(face, chunk_pos.x, chunk_pos.y, chunk_pos.z,
+                                                                   static_cast<Block::Type>(key / 4), glm::ivec4(ao));
+                merged_quad.size = { width, height };
+                u += width - 1;
+            }
+        }
+
+        slice_begin = slice_end;
+    }
+
+    quads = std::move(merged_quads);
+}
+
+// Binary meshing: works on the x row bitmasks of the padded chunk so that hidden faces are culled 18 blocks at a
+// time with shifts and ANDs, and only visible faces are visited. Faces are greedily merged within each section
+// on 16 bit row masks, one plane per face direction, slice and merge key, using the same rule as merge_quads.
+void ChunkMesher::convert_to_quads_binary(const PaddedChunk& padded_chunk) {
+    static_assert(CHUNK_LENGTH == 16 && CHUNK_WIDTH == 16 && SECTION_HEIGHT == 16,
+                  "Binary meshing assumes 16x16x16 sections");
+
+    // bits of a padded row that lie within the chunk
+    constexpr uint32_t chunk_row_mask = ((uint32_t{1} << CHUNK_LENGTH) - 1) << 1;
+    // merge key: block type and uniform ambient occlusion value
+    constexpr int n_merge_keys = static_cast<int>(Block::Type::SIZE) * 4;
+    static_assert(n_merge_keys <= 32, "Merge keys of a plane must fit in a uint32_t");
+
+    // see convert_to_quads
+    bool ambient_occlusion = padded_chunk.get_lod() == 0;
+
+    using PlaneRows = std::array<uint16_t, SECTION_HEIGHT>;
+    std::vector<PlaneRows> planes(6 * SECTION_HEIGHT * n_merge_keys, PlaneRows{});
+    std::array<uint32_t, 6 * SECTION_HEIGHT> used_merge_keys{};
+
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        if (padded_chunk.is_section_skipped(section_index)) {
+            continue;
+        }
+
+        int section_base = section_index * SECTION_HEIGHT;
+
+        for (int section_z = 0; section_z < SECTION_HEIGHT; section_z++) {
+            int z = section_base + section_z;
+
+            for (int y = 0; y < CHUNK_WIDTH; y++) {
+                uint32_t solid = padded_chunk.get_solid_row(y, z) & chunk_row_mask;
+                if (solid == 0) {
+                    continue;
+                }
+
+                uint32_t opaque = padded_chunk.get_opaque_row(y, z);
+
+                // a face is visible if its block is not air and the block it faces is not opaque
+                std::array<uint32_t, 6> visible_faces = {
+                    solid & ~padded_chunk.get_opaque_row(y, z + 1), // TOP
+                    solid & ~padded_chunk.get_opaque_row(y, z - 1), // BOTTOM
+                    solid & ~(opaque << 1),                         // LEFT
+                    solid & ~(opaque >> 1),                         // RIGHT
+                    solid & ~padded_chunk.get_opaque_row(y - 1, z), // FRONT
+                    solid & ~padded_chunk.get_opaque_row(y + 1, z), // BACK
+                };
+
+                for (VoxelQuad::Face face : faces) {
+                    for (uint32_t visible = visible_faces[face]; visible != 0; visible &= visible - 1) {
+                        int bit = std::countr_zero(visible);
+                        int x = bit - 1;
+
+                        // see convert_to_quads, only translucent blocks can face a block of their own type here
+                        Block::Type block_type = padded_chunk.get_block({ x, y, z }).type;
+                        if (Block::is_transparent({ block_type })
+                            && padded_chunk.get_block(glm::ivec3(x, y, z) + block_neighbors[face]).type == block_type) {
+                            continue;
+                        }
+
+                        std::array<int, 8> face_neighbor_opaque{};
+                        for (int i = 0; i < 8 && ambient_occlusion; i++) {
+                            glm::ivec3 offset = face_neighbors[face][i];
+                            face_neighbor_opaque[i] = (padded_chunk.get_opaque_row(y + offset.y, z + offset.z) >> (bit + offset.x)) & 1;
+                        }
+
+                        glm::ivec4 ao = calculate_ao_state(face_neighbor_opaque);
+
+                        if (ao[0] != ao[1] || ao[0] != ao[2] || ao[0] != ao[3]) {
+                            quads.emplace_back(face, x, y, z, block_type, ao);
+                            continue;
+                        }
+
+                        glm::ivec3 section_pos(x, y, section_z);
+                        glm::ivec2 axes = face_plane_axes[face];
+                        int plane = face * SECTION_HEIGHT + section_pos[face_normal_axes[face]];
+                        int merge_key = static_cast<int>(block_type) * 4 + ao[0];
+
+                        planes[plane * n_merge_keys + merge_key][section_pos[axes.y]] |= uint16_t(1u << section_pos[axes.x]);
+                        used_merge_keys[plane] |= uint32_t{1} << merge_key;
+                    }
+                }
+            }
+        }
+
+        for (int plane = 0; plane < 6 * SECTION_HEIGHT; plane++) {
+            VoxelQuad::Face face = faces[plane / SECTION_HEIGHT];
+            int normal_axis = face_normal_axes[face];
+            glm::ivec2 axes = face_plane_axes[face];
+
+            for (uint32_t keys = used_merge_keys[plane]; keys != 0; keys &= keys - 1) {
+                int merge_key = std::countr_zero(keys);
+                PlaneRows& rows = planes[plane * n_merge_keys + merge_key];
+
+                // take the lowest run of each row, then extend it over the following rows while they contain all of it
+                for (int v = 0; v < SECTION_HEIGHT; v++) {
+                    while (rows[v] != 0) {
+                        uint32_t row = rows[v];
+                        int u = std::countr_zero(row);
+                        int width = std::countr_one(row >> u);
+                        uint16_t run = uint16_t(((1u << width) - 1) << u);
+
+                        int height = 1;
+                        while (v + height < SECTION_HEIGHT && (rows[v + height] & run) == run) {
+                            rows[v + height] &= uint16_t(~run);
+                            height++;
+                        }
+                        rows[v] &= uint16_t(~run);
+
+                        glm::ivec3 chunk_pos(0, 0, section_base);
+                        chunk_pos[normal_axis] += plane % SECTION_HEIGHT;
+                        chunk_pos[axes.x] += u;
+                        chunk_pos[axes.y] += v;
+
+                        int ao = merge_key % 4;
+                        VoxelQuad& quad = quads.emplace_back(face, chunk_pos.x, chunk_pos.y, chunk_pos.z,
+                                                             static_cast<Block::Type>(merge_key / 4), glm::ivec4(ao));
+                        quad.size = { width, height };
+                    }
+                }
+            }
+
+            used_merge_keys[plane] = 0;
+        }
+    }
+}
+
+void ChunkMesher::generate_quad_record(const VoxelQuad& quad, const TextureManager& texture_manager) {
+    QuadRecord record{
+        quad.chunk_pos,
+        quad.face,
+        texture_manager.get_texture_index(quad.block_type, quad.face),
+        quad.ao_state,
+        quad.size,
+    };
+
+    for (uint32_t word : record.pack()) {
+        mesh_data.push_back(word);
+    }
+}
@@ -0,0 +1,82 @@
+#include "blocks/chunk_store.hpp"
+
+#include <functional>
+#include <utility>
+
+ChunkStore::ChunkStore(size_t memory_budget) : memory_budget(memory_budget) {}
+
+size_t ChunkStore::KeyHash::operator()(const Key& key) const {
+    size_t hash = std::hash<glm::ivec2>{}(key.chunk_coords);
+    return hash ^ (std::hash<int>{}(key.seed) + 0x9e3779b97f4a7c15 + (hash << 6) + (hash >> 2));
+}
+
+// Blocks of a generated chunk, the object itself and the heap memory of its sections
+static size_t chunk_memory_usage(const Chunk& chunk) {
+    size_t usage = sizeof(Chunk);
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        usage += chunk.get_section(section_index).get_storage().memory_usage();
+    }
+    return usage;
+}
+
+std::optional<Packet> ChunkStore::find_packet(glm::ivec2 chunk_coords, int seed) {
+    auto it = entry_map.find({ chunk_coords, seed });
+    if (it == entry_map.end()) {
+        stats.misses++;
+        return std::nullopt;
+    }
+
+    stats.hits++;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->packet;
+}
+
+const Chunk* ChunkStore::find_chunk(glm::ivec2 chunk_coords, int seed) const {
+    auto it = entry_map.find({ chunk_coords, seed });
+    return it != entry_map.end() ? &it->second->chunk : nullptr;
+}
+
+void ChunkStore::insert(Chunk chunk, Packet packet) {
+    Key key{ chunk.get_chunk_coords(), chunk.get_seed() };
+
+    auto it = entry_map.find(key);
+    if (it != entry_map.end()) {
+        memory_usage -= it->second->memory_usage;
+        entries.erase(it->second);
+        entry_map.erase(it);
+    }
+
+    size_t usage = sizeof(Entry) + chunk_memory_usage(chunk) + packet.payload.capacity();
+    entries.push_front(Entry{ key, std::move(chunk), std::move(packet), usage });
+    entry_map.insert({ key, entries.begin() });
+    memory_usage += usage;
+
+    evict();
+}
+
+const ChunkStoreStats& ChunkStore::get_stats() const {
+    return stats;
+}
+
+size_t ChunkStore::size() const {
+    return entries.size();
+}
+
+size_t ChunkStore::get_memory_usage() const {
+    return memory_usage;
+}
+
+size_t ChunkStore::get_memory_budget() const {
+    return memory_budget;
+}
+
+// The most recent entry is always kept, even if it alone is over the budget
+void ChunkStore::evict() {
+    while (memory_usage > memory_budget && entries.size() > 1) {
+        const Entry& entry = entries.back();
+        memory_usage -= entry.memory_usage;
+        entry_map.erase(entry.key);
+        entries.pop_back();
+        stats.evictions++;
+    }
+}
@@ -0,0 +1,317 @@
+#include "blocks/far_terrain.hpp"
+
+#include "blocks/chunk.hpp"
+#include "blocks/chunk_mesher.hpp"
+#include "graphics/frustum.hpp"
+#include "graphics/texture.hpp"
+#include "utils/assert.hpp"
+#include "utils/logger.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+constexpr int FAR_TILE_BLOCKS = FAR_TILE_CHUNKS * CHUNK_LENGTH;
+constexpr int INDICES_PER_FAR_TILE = (FAR_TILE_SAMPLES - 1) * (FAR_TILE_SAMPLES - 1) * INDICES_PER_QUAD;
+
+FarTerrainData FarTerrainData::generate(glm::ivec2 tile_coords, int seed) {
+    FarTerrainData tile{
+        tile_coords,
+        seed,
+        std::vector<uint8_t>(SAMPLES_PER_FAR_TILE),
+        std::vector<uint8_t>(SAMPLES_PER_FAR_TILE),
+    };
+
+    glm::ivec2 tile_origin = tile_coords * FAR_TILE_BLOCKS;
+    for (int j = 0; j < FAR_TILE_SAMPLES; j++) {
+        for (int i = 0; i < FAR_TILE_SAMPLES; i++) {
+            glm::ivec2 world_column = tile_origin + glm::ivec2(i, j) * FAR_SAMPLE_SPACING;
+            int ground_level = std::clamp(Chunk::get_ground_level(world_column, seed), 0, CHUNK_HEIGHT - 1);
+
+            tile.heights[j * FAR_TILE_SAMPLES + i] = static_cast<uint8_t>(ground_level);
+            tile.top_blocks[j * FAR_TILE_SAMPLES + i] = static_cast<uint8_t>(Chunk::get_generated_block(ground_level, ground_level));
+        }
+    }
+
+    return tile;
+}
+
+FarTerrain::FarTerrain(int seed, int chunk_radius, int far_radius)
+    : seed(seed), chunk_radius(chunk_radius), far_radius(far_radius) {
+    // tiles are kept up to FAR_TILE_CHUNKS chunks past far_radius, see update
+    int tiles_per_side = 2 * (far_radius + FAR_TILE_CHUNKS) / FAR_TILE_CHUNKS + 3;
+    max_tiles = static_cast<size_t>(tiles_per_side * tiles_per_side);
+    for (size_t slot = max_tiles; slot > 0; slot--) {
+        free_slots.push_back(slot - 1);
+    }
+
+    // covered chunks are at most chunk_radius + 2 chunks from the player and tiles at most far_radius +
+    // 2 * FAR_TILE_CHUNKS, so a mask wider than both never maps a drawn chunk onto a covered one
+    covered_size = 1;
+    while (covered_size <= chunk_radius + far_radius + 2 * FAR_TILE_CHUNKS + 2) {
+        covered_size *= 2;
+    }
+    covered_chunks.resize(static_cast<size_t>(covered_size * covered_size), 0);
+
+    glGenVertexArrays(1, &VAO);
+    glBindVertexArray(VAO);
+
+    // every tile has the same grid, each cell is a quad between four samples, anti-clockwise seen from above
+    std::vector<uint32_t> indices;
+    indices.reserve(INDICES_PER_FAR_TILE);
+    for (int j = 0; j < FAR_TILE_SAMPLES - 1; j++) {
+        for (int i = 0; i < FAR_TILE_SAMPLES - 1; i++) {
+            uint32_t first = static_cast<uint32_t>(j * FAR_TILE_SAMPLES + i);
+            std::array<uint32_t, VERTICES_PER_QUAD> corners = {
+                first, first + 1, first + FAR_TILE_SAMPLES + 1, first + FAR_TILE_SAMPLES
+            };
+            for (uint32_t index : QUAD_INDICES) {
+                indices.push_back(corners[index]);
+            }
+        }
+    }
+
+    glGenBuffers(1, &EBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+
+    glGenBuffers(1, &sample_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, sample_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, max_tiles * SAMPLES_PER_FAR_TILE * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+
+    glGenTextures(1, &covered_texture);
+    covered_unit = Texture::n_textures++;
+    glActiveTexture(GL_TEXTURE0 + covered_unit);
+    glBindTexture(GL_TEXTURE_2D, covered_texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_R8UI, covered_size, covered_size);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, covered_size, covered_size, GL_RED_INTEGER, GL_UNSIGNED_BYTE, covered_chunks.data());
+
+    bool shader_loaded = shader.load();
+    debug_assert(shader_loaded, "Error creating far terrain shader");
+    uniforms = {
+        shader.uniform<glm::mat4>("view"),
+        shader.uniform<glm::mat4>("projection"),
+        shader.uniform<glm::vec3>("cameraPos"),
+        shader.uniform<float>("renderRadius"),
+        shader.uniform<glm::vec3>("lightPos"),
+        shader.uniform<int>("textureId"),
+        shader.uniform<int>("coveredChunks"),
+    };
+
+    log_debug("Far terrain sample buffer: %zu tiles, %zu KiB", max_tiles,
+              max_tiles * SAMPLES_PER_FAR_TILE * sizeof(uint32_t) / 1024);
+}
+
+FarTerrain::~FarTerrain() {
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteBuffers(1, &sample_buffer);
+    glDeleteTextures(1, &covered_texture);
+}
+
+void FarTerrain::update(glm::vec3 player_pos) {
+    glm::ivec2 chunk_pos = glm::floor(glm::vec2(player_pos.x / CHUNK_LENGTH, player_pos.y / CHUNK_WIDTH));
+    if (scanned && chunk_pos == center_chunk) {
+        return;
+    }
+    center_chunk = chunk_pos;
+    scanned = true;
+
+    // tiles are unloaded a tile past the ring they are loaded in, so moving back and forth does not reload them
+    std::vector<glm::ivec2> unneeded_tiles;
+    for (const auto& [tile_coords, tile] : loaded_tiles) {
+        if (!is_tile_needed(tile_coords, FAR_TILE_CHUNKS)) {
+            unneeded_tiles.push_back(tile_coords);
+        }
+    }
+    for (glm::ivec2 tile_coords : unneeded_tiles) {
+        unload_tile(tile_coords);
+    }
+
+    glm::ivec2 center_tile = glm::floor(glm::vec2(chunk_pos) / static_cast<float>(FAR_TILE_CHUNKS));
+    int tile_radius = far_radius / FAR_TILE_CHUNKS + 1;
+    for (int i = -tile_radius; i <= tile_radius; i++) {
+        for (int j = -tile_radius; j <= tile_radius; j++) {
+            glm::ivec2 tile_coords = center_tile + glm::ivec2(i, j);
+            if (!is_tile_needed(tile_coords, 0)
+                || loaded_tiles.contains(tile_coords)
+                || request_tile_queue_set.contains(tile_coords)) {
+                continue;
+            }
+
+            request_tile_queue.push(tile_coords);
+            request_tile_queue_set.insert(tile_coords);
+        }
+    }
+}
+
+void FarTerrain::request_all_tiles(ClientInterface& client) {
+    while (!request_tile_queue.empty()) {
+        FarTerrainRequest request{ request_tile_queue.front(), seed };
+        request_tile_queue.pop();
+        client.send(request.serialize());
+    }
+}
+
+void FarTerrain::generate_requested_tiles() {
+    while (!request_tile_queue.empty()) {
+        received_tile_queue.push(FarTerrainData::generate(request_tile_queue.front(), seed));
+        request_tile_queue.pop();
+    }
+}
+
+void FarTerrain::receive_tile_data(Packet packet) {
+    std::optional<FarTerrainData> tile = FarTerrainData::deserialize(std::move(packet));
+    if (!tile.has_value()) {
+        log_error("Dropping a far terrain packet of the wrong size");
+        return;
+    }
+    received_tile_queue.push(std::move(*tile));
+}
+
+// Samples are packed as the ground level in the low byte and the texture index of the top face of the top block in
+// the next one, see far_terrain.vert
+void FarTerrain::load_tiles(int num_tiles, const TextureManager& texture_manager) {
+    std::vector<uint32_t> samples(SAMPLES_PER_FAR_TILE);
+
+    int n_loaded = 0;
+    while (n_loaded < num_tiles && !received_tile_queue.empty()) {
+        FarTerrainData tile = std::move(received_tile_queue.front());
+        received_tile_queue.pop();
+        request_tile_queue_set.erase(tile.tile_coords);
+
+        if (loaded_tiles.contains(tile.tile_coords) || !is_tile_needed(tile.tile_coords, FAR_TILE_CHUNKS)) {
+            continue;
+        }
+        if (free_slots.empty()) {
+            log_error("No free far terrain slot for tile (%d, %d)", tile.tile_coords.x, tile.tile_coords.y);
+            continue;
+        }
+        bool known_blocks = std::all_of(tile.top_blocks.begin(), tile.top_blocks.end(), [](uint8_t top_block) {
+            return top_block < static_cast<uint8_t>(Block::Type::SIZE);
+        });
+        if (!known_blocks) {
+            log_error("Dropping far terrain tile (%d, %d) with unknown blocks", tile.tile_coords.x, tile.tile_coords.y);
+            continue;
+        }
+
+        size_t slot = free_slots.back();
+        free_slots.pop_back();
+
+        uint8_t min_height = UINT8_MAX;
+        uint8_t max_height = 0;
+        for (size_t i = 0; i < samples.size(); i++) {
+            Block::Type top_block = static_cast<Block::Type>(tile.top_blocks[i]);
+            int texture_index = texture_manager.get_texture_index(top_block, VoxelQuad::Face::TOP);
+            samples[i] = tile.heights[i] | static_cast<uint32_t>(texture_index) << 8;
+            min_height = std::min(min_height, tile.heights[i]);
+            max_height = std::max(max_height, tile.heights[i]);
+        }
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, sample_buffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, slot * SAMPLES_PER_FAR_TILE * sizeof(uint32_t),
+                        SAMPLES_PER_FAR_TILE * sizeof(uint32_t), samples.data());
+
+        // the surface is the top of the ground level block
+        loaded_tiles[tile.tile_coords] = { slot, min_height + 1.0f, max_height + 1.0f };
+        n_loaded++;
+    }
+}
+
+void FarTerrain::set_covered_chunks(const std::vector<glm::ivec2>& chunk_coords) {
+    std::vector<uint8_t> new_covered_chunks(covered_chunks.size(), 0);
+    for (glm::ivec2 chunk_pos : chunk_coords) {
+        int x = chunk_pos.x & (covered_size - 1);
+        int y = chunk_pos.y & (covered_size - 1);
+        new_covered_chunks[y * covered_size + x] = 1;
+    }
+
+    // the set only changes when chunks are meshed or unloaded
+    if (new_covered_chunks == covered_chunks) {
+        return;
+    }
+    covered_chunks = std::move(new_covered_chunks);
+
+    glActiveTexture(GL_TEXTURE0 + covered_unit);
+    glBindTexture(GL_TEXTURE_2D, covered_texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, covered_size, covered_size, GL_RED_INTEGER, GL_UNSIGNED_BYTE, covered_chunks.data());
+}
+
+void FarTerrain::draw(const glm::mat4& view, const glm::mat4& projection, glm::vec3 camera_pos, float render_radius,
+                      glm::vec3 light_pos, GLuint texture_unit) {
+    Frustum view_frustum(projection * view);
+
+    draw_buffer.clear();
+    for (const auto& [tile_coords, tile] : loaded_tiles) {
+        glm::vec2 origin = tile_coords * FAR_TILE_BLOCKS;
+        glm::vec3 min(origin, tile.min_z);
+        glm::vec3 max(origin + static_cast<float>(FAR_TILE_BLOCKS), tile.max_z);
+        if (!view_frustum.intersects_aabb(min, max)) {
+            continue;
+        }
+
+        draw_buffer.add({
+            glm::vec3(origin, 0.0f),
+            VAO,
+            tile.slot * SAMPLES_PER_FAR_TILE,
+            shader.id(),
+            texture_unit,
+            INDICES_PER_FAR_TILE,
+        });
+    }
+
+    if (draw_buffer.size() == 0) {
+        return;
+    }
+
+    shader.use();
+    shader.set(uniforms.view, view);
+    shader.set(uniforms.projection, projection);
+    shader.set(uniforms.camera_pos, camera_pos);
+    shader.set(uniforms.render_radius, render_radius);
+    shader.set(uniforms.light_pos, light_pos);
+    shader.set(uniforms.texture_id, static_cast<int>(texture_unit));
+    shader.set(uniforms.covered_chunks, static_cast<int>(covered_unit));
+
+    // rebound in case another texture was bound to the unit while it was active
+    glActiveTexture(GL_TEXTURE0 + covered_unit);
+    glBindTexture(GL_TEXTURE_2D, covered_texture);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SAMPLE_BUFFER_BINDING, sample_buffer);
+    draw_buffer.draw();
+}
+
+bool FarTerrain::reload_shader() {
+    return shader.load();
+}
+
+size_t FarTerrain::get_num_tiles() const {
+    return loaded_tiles.size();
+}
+
+size_t FarTerrain::get_memory_usage() const {
+    return loaded_tiles.size() * SAMPLES_PER_FAR_TILE * sizeof(uint32_t);
+}
+
+// A tile is needed while part of it is within far_radius chunks of the player and part of it is outside of the
+// chunk radius, where chunks are not loaded. margin widens the ring on both sides
+bool FarTerrain::is_tile_needed(glm::ivec2 tile_coords, int margin) const {
+    glm::ivec2 min_chunk = tile_coords * FAR_TILE_CHUNKS;
+    glm::ivec2 max_chunk = min_chunk + (FAR_TILE_CHUNKS - 1);
+
+    glm::vec2 nearest = glm::clamp(center_chunk, min_chunk, max_chunk) - center_chunk;
+    glm::vec2 farthest = glm::max(glm::abs(min_chunk - center_chunk), glm::abs(max_chunk - center_chunk));
+    int nearest_dist = glm::floor(glm::length(nearest));
+    int farthest_dist = glm::floor(glm::length(farthest));
+
+    return nearest_dist <= far_radius + margin && farthest_dist > chunk_radius - margin;
+}
+
+void FarTerrain::unload_tile(glm::ivec2 tile_coords) {
+    auto it = loaded_tiles.find(tile_coords);
+    debug_assert(it != loaded_tiles.end(), "Unloading non-existent far terrain tile");
+
+    free_slots.push_back(it->second.slot);
+    loaded_tiles.erase(it);
+}
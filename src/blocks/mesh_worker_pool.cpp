@@ -0,0 +1,101 @@
+#include "blocks/mesh_worker_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+MeshWorkerPool::MeshWorkerPool(int num_threads) {
+    for (int i = 0; i < std::max(num_threads, 1); i++) {
+        workers.emplace_back(&MeshWorkerPool::worker_loop, this);
+    }
+}
+
+MeshWorkerPool::~MeshWorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    job_available.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+int MeshWorkerPool::default_num_threads() {
+    int hardware_threads = static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(hardware_threads - 1, 1);
+}
+
+void MeshWorkerPool::submit(MeshJob job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    job_available.notify_one();
+}
+
+int MeshWorkerPool::cancel(glm::ivec2 chunk_coords) {
+    size_t n_cancelled = 0;
+    bool finished = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        n_cancelled = std::erase_if(jobs, [chunk_coords](const MeshJob& job) { return job.chunk_coords == chunk_coords; });
+        finished = jobs.empty() && n_active_jobs == 0;
+    }
+
+    if (finished) {
+        jobs_finished.notify_all();
+    }
+
+    return static_cast<int>(n_cancelled);
+}
+
+std::vector<MeshResult> MeshWorkerPool::take_results() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::exchange(results, {});
+}
+
+void MeshWorkerPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    jobs_finished.wait(lock, [this]() { return jobs.empty() && n_active_jobs == 0; });
+}
+
+int MeshWorkerPool::get_num_threads() const {
+    return static_cast<int>(workers.size());
+}
+
+void MeshWorkerPool::worker_loop() {
+    // each worker reuses its own quad buffers between jobs
+    ChunkMesher chunk_mesher;
+
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        job_available.wait(lock, [this]() { return stopping || !jobs.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        MeshJob job = std::move(jobs.front());
+        jobs.pop_front();
+        n_active_jobs++;
+        lock.unlock();
+
+        MeshResult result{
+            job.chunk_coords,
+            job.version,
+            chunk_mesher.mesh(job.padded_chunk, *job.texture_manager, job.meshing_mode),
+            compute_chunk_visibility(job.padded_chunk),
+        };
+
+        lock.lock();
+        results.push_back(std::move(result));
+        n_active_jobs--;
+        bool finished = jobs.empty() && n_active_jobs == 0;
+        lock.unlock();
+
+        if (finished) {
+            jobs_finished.notify_all();
+        }
+    }
+}
@@ -0,0 +1,248 @@
+#include "blocks/padded_chunk.hpp"
+
+#include "blocks/chunk.hpp"
+#include "utils/assert.hpp"
+
+#include <algorithm>
+
+using BlockCounts = std::array<int, static_cast<size_t>(Block::Type::SIZE)>;
+
+// Block a downsampled cell of n_blocks blocks is filled with: its most common non-air block, or air if most of it
+// is air. Ties go to the lowest type so that the result does not depend on the order of the blocks
+static uint8_t downsampled_type(const BlockCounts& counts, int n_blocks) {
+    if (2 * counts[Block::Type::AIR] > n_blocks) {
+        return static_cast<uint8_t>(Block::Type::AIR);
+    }
+    return static_cast<uint8_t>(std::max_element(counts.begin() + 1, counts.end()) - counts.begin());
+}
+
+PaddedChunk::PaddedChunk(const Chunk& chunk,
+                         const std::vector<Chunk>& loaded_chunks,
+                         const std::unordered_map<glm::ivec2, size_t>& chunk_index_map)
+    : chunk_coords(chunk.get_chunk_coords()),
+      lod(chunk.get_lod()),
+      blocks(LENGTH * WIDTH * HEIGHT, Block::Type::AIR),
+      opaque_rows(WIDTH * HEIGHT, 0),
+      solid_rows(WIDTH * HEIGHT, 0) {
+
+    copy_blocks(chunk, { 0, 0 }, { CHUNK_LENGTH - 1, CHUNK_WIDTH - 1 }, { 0, 0 });
+
+    // copy the facing column or slab of each of the 8 neighbors into the border, as the neighbor is meshed
+    for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            if (dx == 0 && dy == 0) {
+                continue;
+            }
+
+            auto it = chunk_index_map.find(chunk_coords + glm::ivec2(dx, dy));
+            if (it == chunk_index_map.end()) {
+                continue;
+            }
+
+            // the border facing a finer neighbor stays air, so the faces along it are kept as a skirt
+            const Chunk& neighbor = loaded_chunks[it->second];
+            if (neighbor.get_lod() < lod) {
+                continue;
+            }
+
+            glm::ivec2 min_pos(dx == -1 ? CHUNK_LENGTH - 1 : 0, dy == -1 ? CHUNK_WIDTH - 1 : 0);
+            glm::ivec2 max_pos(dx == 1 ? 0 : CHUNK_LENGTH - 1, dy == 1 ? 0 : CHUNK_WIDTH - 1);
+            glm::ivec2 offset(dx * CHUNK_LENGTH, dy * CHUNK_WIDTH);
+            if (neighbor.get_lod() == 0) {
+                copy_blocks(neighbor, min_pos, max_pos, offset);
+            } else {
+                copy_downsampled_blocks(neighbor, min_pos, max_pos, offset, 1 << neighbor.get_lod());
+            }
+        }
+    }
+
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        const ChunkSection& section = chunk.get_section(section_index);
+        empty_sections[section_index] = section.is_empty();
+        opaque_sections[section_index] = section.is_opaque();
+        skipped_sections[section_index] = section.is_empty()
+            || chunk.is_section_hidden(section_index, loaded_chunks, chunk_index_map);
+    }
+
+    if (lod > 0) {
+        downsample(1 << lod);
+    }
+    build_rows();
+}
+
+bool PaddedChunk::is_section_skipped(int section_index) const {
+    return skipped_sections[section_index];
+}
+
+bool PaddedChunk::is_section_empty(int section_index) const {
+    return empty_sections[section_index];
+}
+
+bool PaddedChunk::is_section_opaque(int section_index) const {
+    return opaque_sections[section_index];
+}
+
+glm::ivec2 PaddedChunk::get_chunk_coords() const {
+    return chunk_coords;
+}
+
+int PaddedChunk::get_lod() const {
+    return lod;
+}
+
+// Copies blocks with x and y in [min_pos, max_pos] from chunk, placing them at their position + offset
+void PaddedChunk::copy_blocks(const Chunk& chunk, glm::ivec2 min_pos, glm::ivec2 max_pos, glm::ivec2 offset) {
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        const ChunkSection& section = chunk.get_section(section_index);
+
+        // the array starts out as air
+        if (section.is_empty()) {
+            continue;
+        }
+
+        int section_base = section_index * SECTION_HEIGHT;
+
+        // sections with a single palette entry are filled row by row without decoding
+        if (section.get_storage().get_bits_per_index() == 0) {
+            uint8_t value = static_cast<uint8_t>(section.get_storage().get_palette()[0]);
+            for (int z = 0; z < SECTION_HEIGHT; z++) {
+                for (int y = min_pos.y; y <= max_pos.y; y++) {
+                    std::fill_n(&blocks[to_index({ min_pos.x + offset.x, y + offset.y, section_base + z })],
+                                max_pos.x - min_pos.x + 1, value);
+                }
+            }
+            continue;
+        }
+
+        for (int z = 0; z < SECTION_HEIGHT; z++) {
+            for (int y = min_pos.y; y <= max_pos.y; y++) {
+                for (int x = min_pos.x; x <= max_pos.x; x++) {
+                    blocks[to_index({ x + offset.x, y + offset.y, section_base + z })] =
+                        static_cast<uint8_t>(section.get_block({ x, y, z }).type);
+                }
+            }
+        }
+    }
+}
+
+// Like copy_blocks, but every block takes the type of the cell_size^3 cell of chunk it is in, as downsample would
+// fill it
+void PaddedChunk::copy_downsampled_blocks(const Chunk& chunk,
+                                          glm::ivec2 min_pos,
+                                          glm::ivec2 max_pos,
+                                          glm::ivec2 offset,
+                                          int cell_size) {
+    glm::ivec2 min_cell = (min_pos / cell_size) * cell_size;
+
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        const ChunkSection& section = chunk.get_section(section_index);
+        if (section.is_empty()) {
+            continue;
+        }
+
+        int section_base = section_index * SECTION_HEIGHT;
+        for (int z = 0; z < SECTION_HEIGHT; z += cell_size) {
+            for (int y = min_cell.y; y <= max_pos.y; y += cell_size) {
+                for (int x = min_cell.x; x <= max_pos.x; x += cell_size) {
+                    BlockCounts counts{};
+                    for (int dz = 0; dz < cell_size; dz++) {
+                        for (int dy = 0; dy < cell_size; dy++) {
+                            for (int dx = 0; dx < cell_size; dx++) {
+                                counts[section.get_block({ x + dx, y + dy, z + dz }).type]++;
+                            }
+                        }
+                    }
+                    uint8_t cell_type = downsampled_type(counts, cell_size * cell_size * cell_size);
+
+                    // only the part of the cell inside the copied range
+                    for (int dz = 0; dz < cell_size; dz++) {
+                        for (int cell_y = std::max(y, min_pos.y); cell_y <= std::min(y + cell_size - 1, max_pos.y); cell_y++) {
+                            int first_x = std::max(x, min_pos.x);
+                            int last_x = std::min(x + cell_size - 1, max_pos.x);
+                            std::fill_n(&blocks[to_index({ first_x + offset.x, cell_y + offset.y, section_base + z + dz })],
+                                        last_x - first_x + 1, cell_type);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Replaces every cell_size^3 cell of the chunk with its most common non-air block, or air if most of it is air.
+// Cells never cross sections, so empty sections stay empty and are skipped
+void PaddedChunk::downsample(int cell_size) {
+    debug_assert(SECTION_HEIGHT % cell_size == 0 && CHUNK_LENGTH % cell_size == 0 && CHUNK_WIDTH % cell_size == 0,
+                 "Downsampled cells must tile sections");
+
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        if (empty_sections[section_index]) {
+            continue;
+        }
+
+        for (int z = section_index * SECTION_HEIGHT; z < (section_index + 1) * SECTION_HEIGHT; z += cell_size) {
+            for (int y = 0; y < CHUNK_WIDTH; y += cell_size) {
+                for (int x = 0; x < CHUNK_LENGTH; x += cell_size) {
+                    BlockCounts counts{};
+                    for (int dz = 0; dz < cell_size; dz++) {
+                        for (int dy = 0; dy < cell_size; dy++) {
+                            const uint8_t* row = &blocks[to_index({ x, y + dy, z + dz })];
+                            for (int dx = 0; dx < cell_size; dx++) {
+                                counts[row[dx]]++;
+                            }
+                        }
+                    }
+
+                    uint8_t cell_type = downsampled_type(counts, cell_size * cell_size * cell_size);
+
+                    for (int dz = 0; dz < cell_size; dz++) {
+                        for (int dy = 0; dy < cell_size; dy++) {
+                            std::fill_n(&blocks[to_index({ x, y + dy, z + dz })], cell_size, cell_type);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Rows are only built for meshed sections and the layers just above and below them, the rest stay empty
+void PaddedChunk::build_rows() {
+    static_assert(LENGTH <= 32, "Padded rows must fit in a uint32_t");
+
+    std::array<uint32_t, static_cast<size_t>(Block::Type::SIZE)> opaque_types{};
+    std::array<uint32_t, static_cast<size_t>(Block::Type::SIZE)> solid_types{};
+    for (size_t type = 0; type < opaque_types.size(); type++) {
+        Block block{ static_cast<Block::Type>(type) };
+        opaque_types[type] = !Block::is_transparent(block);
+        solid_types[type] = block.type != Block::Type::AIR;
+    }
+
+    std::array<bool, HEIGHT> needed_layers{};
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        if (!skipped_sections[section_index]) {
+            // layer index is z + 1
+            std::fill_n(&needed_layers[section_index * SECTION_HEIGHT], SECTION_HEIGHT + 2, true);
+        }
+    }
+
+    for (int z = -1; z <= CHUNK_HEIGHT; z++) {
+        if (!needed_layers[z + 1]) {
+            continue;
+        }
+
+        for (int y = -1; y <= CHUNK_WIDTH; y++) {
+            const uint8_t* row = &blocks[to_index({ -1, y, z })];
+            uint32_t opaque_row = 0;
+            uint32_t solid_row = 0;
+
+            for (int i = 0; i < LENGTH; i++) {
+                opaque_row |= opaque_types[row[i]] << i;
+                solid_row |= solid_types[row[i]] << i;
+            }
+
+            opaque_rows[to_row_index(y, z)] = opaque_row;
+            solid_rows[to_row_index(y, z)] = solid_row;
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#include "blocks/palette_storage.hpp"
+
+#include "utils/assert.hpp"
+
+PaletteStorage::PaletteStorage(size_t size, Block block) : n_blocks(size), palette{ block.type } {}
+
+void PaletteStorage::set(size_t index, Block block) {
+    int palette_index = get_or_add_palette_index(block.type);
+
+    // uniform storage: the only palette entry is already the requested block
+    if (bits_per_index == 0) {
+        return;
+    }
+
+    size_t bit = index * bits_per_index;
+    uint64_t mask = ((uint64_t{1} << bits_per_index) - 1) << (bit & 63);
+    uint64_t& word = indices[bit >> 6];
+    word = (word & ~mask) | (static_cast<uint64_t>(palette_index) << (bit & 63));
+}
+
+void PaletteStorage::fill(Block block) {
+    palette.assign(1, block.type);
+    bits_per_index = 0;
+    indices.clear();
+    indices.shrink_to_fit();
+}
+
+size_t PaletteStorage::size() const {
+    return n_blocks;
+}
+
+int PaletteStorage::get_bits_per_index() const {
+    return bits_per_index;
+}
+
+const std::vector<Block::Type>& PaletteStorage::get_palette() const {
+    return palette;
+}
+
+size_t PaletteStorage::memory_usage() const {
+    return palette.capacity() * sizeof(Block::Type) + indices.capacity() * sizeof(uint64_t);
+}
+
+// Smallest supported index width that can address n_entries palette entries
+static int bits_for_palette_size(size_t n_entries) {
+    int bits = 0;
+    while ((size_t{1} << bits) < n_entries) {
+        bits = bits == 0 ? 1 : bits * 2;
+    }
+    return bits;
+}
+
+int PaletteStorage::get_or_add_palette_index(Block::Type type) {
+    // palettes hold a handful of entries, so a linear scan beats hashing
+    for (size_t i = 0; i < palette.size(); i++) {
+        if (palette[i] == type) {
+            return static_cast<int>(i);
+        }
+    }
+
+    // a full palette first drops the types that were overwritten everywhere, which may leave room for the new one
+    std::vector<uint32_t> remap;
+    if (bits_per_index > 0 && palette.size() == (size_t{1} << bits_per_index)) {
+        remap = compact_palette();
+    }
+
+    palette.push_back(type);
+
+    int new_bits_per_index = bits_for_palette_size(palette.size());
+    debug_assert(new_bits_per_index <= 16, "Palette has too many block types");
+
+    if (new_bits_per_index != bits_per_index || !remap.empty()) {
+        repack(new_bits_per_index, remap);
+    }
+
+    return static_cast<int>(palette.size() - 1);
+}
+
+// Removes the palette entries no block refers to, keeping the order of the others. Returns the new index of every
+// old entry, or nothing if all of them are in use. The indices have to be repacked with the returned mapping
+std::vector<uint32_t> PaletteStorage::compact_palette() {
+    std::vector<size_t> uses(palette.size(), 0);
+    for (size_t i = 0; i < n_blocks; i++) {
+        uses[get_palette_index(i)]++;
+    }
+
+    std::vector<uint32_t> remap(palette.size(), 0);
+    std::vector<Block::Type> used_palette;
+    for (size_t i = 0; i < palette.size(); i++) {
+        if (uses[i] > 0) {
+            remap[i] = static_cast<uint32_t>(used_palette.size());
+            used_palette.push_back(palette[i]);
+        }
+    }
+
+    if (used_palette.size() == palette.size()) {
+        return {};
+    }
+    palette = std::move(used_palette);
+    return remap;
+}
+
+// Repack every index with another bit width, mapping each palette index through remap if it is given
+void PaletteStorage::repack(int new_bits_per_index, const std::vector<uint32_t>& remap) {
+    std::vector<uint64_t> new_indices((n_blocks * new_bits_per_index + 63) / 64, 0);
+
+    // going from uniform storage every index is 0, which is what the zeroed buffer already holds
+    if (bits_per_index != 0) {
+        for (size_t i = 0; i < n_blocks; i++) {
+            uint64_t palette_index = get_palette_index(i);
+            if (!remap.empty()) {
+                palette_index = remap[palette_index];
+            }
+
+            size_t new_bit = i * new_bits_per_index;
+            new_indices[new_bit >> 6] |= palette_index << (new_bit & 63);
+        }
+    }
+
+    indices = std::move(new_indices);
+    bits_per_index = new_bits_per_index;
+}
@@ -0,0 +1,221 @@
+#include "blocks/section_visibility.hpp"
+
+#include "blocks/chunk.hpp"
+#include "blocks/padded_chunk.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <deque>
+
+constexpr int N_FACES = 6;
+constexpr int SECTION_LENGTH = 16;
+constexpr int BLOCKS_PER_SECTION_LAYER = SECTION_LENGTH * SECTION_LENGTH;
+constexpr uint32_t FULL_ROW = (uint32_t(1) << SECTION_LENGTH) - 1;
+
+static_assert(CHUNK_LENGTH == SECTION_LENGTH && CHUNK_WIDTH == SECTION_LENGTH && SECTION_HEIGHT == SECTION_LENGTH,
+              "Sections are expected to be 16x16x16 cubes");
+
+// steps to the neighboring section through each face, in VoxelQuad::Face order
+constexpr std::array<glm::ivec3, N_FACES> face_directions = {
+    glm::ivec3{ 0,  0,  1}, // TOP
+    glm::ivec3{ 0,  0, -1}, // BOTTOM
+    glm::ivec3{-1,  0,  0}, // LEFT
+    glm::ivec3{ 1,  0,  0}, // RIGHT
+    glm::ivec3{ 0, -1,  0}, // FRONT
+    glm::ivec3{ 0,  1,  0}, // BACK
+};
+
+// faces come in opposite pairs
+static int opposite_face(int face) {
+    return face ^ 1;
+}
+
+SectionVisibility SectionVisibility::all_connected() {
+    SectionVisibility visibility;
+    visibility.connections = (uint64_t(1) << (N_FACES * N_FACES)) - 1;
+    return visibility;
+}
+
+bool SectionVisibility::are_connected(int face_a, int face_b) const {
+    return (connections >> (N_FACES * face_a + face_b)) & 1;
+}
+
+void SectionVisibility::connect(int face_a, int face_b) {
+    connections |= uint64_t(1) << (N_FACES * face_a + face_b);
+    connections |= uint64_t(1) << (N_FACES * face_b + face_a);
+}
+
+// Bits of the run of set bits of free_blocks that contains the single bit seed
+static uint32_t row_run(uint32_t free_blocks, uint32_t seed) {
+    // adding the seed carries through the bits above it up to the first unset one
+    uint32_t upper = ((free_blocks + seed) ^ free_blocks) & free_blocks;
+    // the run ends below at the highest unset bit under the seed
+    uint32_t lower_gaps = ~free_blocks & (seed - 1);
+    uint32_t lower = (seed - 1) & ~((uint32_t(1) << std::bit_width(lower_gaps)) - 1);
+    return upper | lower;
+}
+
+// Flood fills every group of connected transparent blocks a row span at a time and connects all the faces each
+// group touches
+SectionVisibility SectionVisibility::compute(const PaddedChunk& padded_chunk, int section_index) {
+    if (padded_chunk.is_section_empty(section_index)) {
+        return all_connected();
+    }
+
+    SectionVisibility visibility;
+    if (padded_chunk.is_section_opaque(section_index)) {
+        return visibility;
+    }
+
+    // rows of 16 blocks along x indexed by y + 16 * z; opaque blocks start out visited. Sections that are neither
+    // empty nor opaque are never skipped, so the padded chunk has their rows
+    int section_base = section_index * SECTION_HEIGHT;
+    std::array<uint32_t, BLOCKS_PER_SECTION_LAYER> visited{};
+    for (int z = 0; z < SECTION_LENGTH; z++) {
+        for (int y = 0; y < SECTION_LENGTH; y++) {
+            visited[SECTION_LENGTH * z + y] = (padded_chunk.get_opaque_row(y, section_base + z) >> 1) & FULL_ROW;
+        }
+    }
+
+    // (row index, seed bit) of spans to visit
+    std::vector<std::pair<int, uint32_t>> stack;
+    for (int start_row = 0; start_row < BLOCKS_PER_SECTION_LAYER; start_row++) {
+        while (visited[start_row] != FULL_ROW) {
+            uint32_t start_seed = ~visited[start_row] & (visited[start_row] + 1);
+            stack.emplace_back(start_row, start_seed);
+            int touched_faces = 0;
+
+            while (!stack.empty()) {
+                auto [row, seed] = stack.back();
+                stack.pop_back();
+                if (visited[row] & seed) {
+                    continue;
+                }
+
+                uint32_t run = row_run(~visited[row] & FULL_ROW, seed);
+                visited[row] |= run;
+
+                int y = row % SECTION_LENGTH;
+                int z = row / SECTION_LENGTH;
+                touched_faces |= (run & 1) ? 1 << VoxelQuad::LEFT : 0;
+                touched_faces |= (run >> (SECTION_LENGTH - 1)) ? 1 << VoxelQuad::RIGHT : 0;
+
+                // rows on the section boundary touch that face; otherwise the spans next to this one are queued
+                auto visit = [&](bool on_face, int face, int neighbor_row) {
+                    if (on_face) {
+                        touched_faces |= 1 << face;
+                        return;
+                    }
+
+                    uint32_t free_blocks = ~visited[neighbor_row] & FULL_ROW;
+                    uint32_t candidates = run & free_blocks;
+                    while (candidates) {
+                        uint32_t candidate = candidates & -candidates;
+                        stack.emplace_back(neighbor_row, candidate);
+                        candidates &= ~row_run(free_blocks, candidate);
+                    }
+                };
+                visit(z == SECTION_LENGTH - 1, VoxelQuad::TOP, row + SECTION_LENGTH);
+                visit(z == 0, VoxelQuad::BOTTOM, row - SECTION_LENGTH);
+                visit(y == 0, VoxelQuad::FRONT, row - 1);
+                visit(y == SECTION_LENGTH - 1, VoxelQuad::BACK, row + 1);
+            }
+
+            for (int face_a = 0; face_a < N_FACES; face_a++) {
+                for (int face_b = 0; face_b < N_FACES; face_b++) {
+                    if ((touched_faces >> face_a) & (touched_faces >> face_b) & 1) {
+                        visibility.connect(face_a, face_b);
+                    }
+                }
+            }
+        }
+    }
+
+    return visibility;
+}
+
+ChunkVisibility compute_chunk_visibility(const PaddedChunk& padded_chunk) {
+    ChunkVisibility chunk_visibility;
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        chunk_visibility[section_index] = SectionVisibility::compute(padded_chunk, section_index);
+    }
+    return chunk_visibility;
+}
+
+struct SectionStep {
+    size_t chunk_index;
+    glm::ivec3 section_pos;
+    // face the section was entered through, -1 for the camera section
+    int entry_face;
+    // mask of the directions taken from the camera section so far, which are never reversed
+    int directions;
+};
+
+void find_visible_sections(glm::vec3 camera_position,
+                           const Frustum& frustum,
+                           const std::vector<Chunk>& loaded_chunks,
+                           const std::unordered_map<glm::ivec2, size_t>& chunk_index_map,
+                           std::vector<uint16_t>& visible_sections) {
+    visible_sections.assign(loaded_chunks.size(), 0);
+
+    glm::ivec3 camera_section(static_cast<int>(std::floor(camera_position.x / CHUNK_LENGTH)),
+                              static_cast<int>(std::floor(camera_position.y / CHUNK_WIDTH)),
+                              static_cast<int>(std::floor(camera_position.z / SECTION_HEIGHT)));
+    // above or below the world the search starts from the nearest section, which sees in every direction
+    camera_section.z = std::clamp(camera_section.z, 0, SECTIONS_PER_CHUNK - 1);
+
+    auto camera_chunk = chunk_index_map.find(glm::ivec2(camera_section));
+    if (camera_chunk == chunk_index_map.end()) {
+        // nothing to search from, so nothing can be ruled out
+        visible_sections.assign(loaded_chunks.size(), UINT16_MAX);
+        return;
+    }
+
+    std::deque<SectionStep> queue;
+    queue.push_back({ camera_chunk->second, camera_section, -1, 0 });
+    visible_sections[camera_chunk->second] |= 1 << camera_section.z;
+
+    while (!queue.empty()) {
+        SectionStep step = queue.front();
+        queue.pop_front();
+
+        const SectionVisibility& visibility = loaded_chunks[step.chunk_index].get_section_visibility()[step.section_pos.z];
+
+        for (int face = 0; face < N_FACES; face++) {
+            if (step.directions & (1 << opposite_face(face))) {
+                continue;
+            }
+            if (step.entry_face != -1 && !visibility.are_connected(step.entry_face, face)) {
+                continue;
+            }
+
+            glm::ivec3 neighbor_pos = step.section_pos + face_directions[face];
+            if (neighbor_pos.z < 0 || neighbor_pos.z >= SECTIONS_PER_CHUNK) {
+                continue;
+            }
+
+            size_t neighbor_index = step.chunk_index;
+            if (face_directions[face].z == 0) {
+                auto it = chunk_index_map.find(glm::ivec2(neighbor_pos));
+                if (it == chunk_index_map.end()) {
+                    continue;
+                }
+                neighbor_index = it->second;
+            }
+
+            uint16_t section_bit = static_cast<uint16_t>(1 << neighbor_pos.z);
+            if (visible_sections[neighbor_index] & section_bit) {
+                continue;
+            }
+
+            glm::vec3 section_min(neighbor_pos.x * CHUNK_LENGTH, neighbor_pos.y * CHUNK_WIDTH, neighbor_pos.z * SECTION_HEIGHT);
+            if (!frustum.intersects_aabb(section_min, section_min + glm::vec3(CHUNK_LENGTH, CHUNK_WIDTH, SECTION_HEIGHT))) {
+                continue;
+            }
+
+            visible_sections[neighbor_index] |= section_bit;
+            queue.push_back({ neighbor_index, neighbor_pos, opposite_face(face), step.directions | (1 << face) });
+        }
+    }
+}
@@ -0,0 +1,130 @@
+#include "blocks/translucency_sorter.hpp"
+
+#include "blocks/quad_record.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+TranslucencySorter::TranslucencySorter() : worker(&TranslucencySorter::worker_loop, this) {}
+
+TranslucencySorter::~TranslucencySorter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queued_jobs.clear();
+        job_order.clear();
+    }
+    job_available.notify_all();
+    worker.join();
+}
+
+// offset of each face from its block position along the face normal, see face_corners in voxel.vert
+constexpr std::array<glm::vec3, 6> face_offsets = {
+    glm::vec3{ 0.0f, 0.0f, 1.0f }, // TOP
+    glm::vec3{ 0.0f, 0.0f, 0.0f }, // BOTTOM
+    glm::vec3{ 0.0f, 0.0f, 0.0f }, // LEFT
+    glm::vec3{ 1.0f, 0.0f, 0.0f }, // RIGHT
+    glm::vec3{ 0.0f, 0.0f, 0.0f }, // FRONT
+    glm::vec3{ 0.0f, 1.0f, 0.0f }, // BACK
+};
+
+// axes spanned by each face, QuadRecord::size is measured along these
+constexpr std::array<glm::ivec2, 6> face_plane_axes = {
+    glm::ivec2{ 0, 1 }, // TOP
+    glm::ivec2{ 0, 1 }, // BOTTOM
+    glm::ivec2{ 1, 2 }, // LEFT
+    glm::ivec2{ 1, 2 }, // RIGHT
+    glm::ivec2{ 0, 2 }, // FRONT
+    glm::ivec2{ 0, 2 }, // BACK
+};
+
+static glm::vec3 quad_center(const QuadRecord& record) {
+    glm::vec3 center = glm::vec3(record.chunk_pos) + face_offsets[record.face];
+    glm::ivec2 axes = face_plane_axes[record.face];
+    center[axes.x] += 0.5f * static_cast<float>(record.size.x);
+    center[axes.y] += 0.5f * static_cast<float>(record.size.y);
+    return center;
+}
+
+void TranslucencySorter::sort_back_to_front(std::vector<uint32_t>& quad_data, const SectionQuadOffsets& sections,
+                                            glm::vec3 camera_pos) {
+    struct SortKey {
+        float distance_squared;
+        uint32_t quad;
+    };
+
+    size_t n_quads = quad_data.size() / QUAD_RECORD_WORDS;
+    std::vector<SortKey> keys(n_quads);
+    for (size_t i = 0; i < n_quads; i++) {
+        QuadRecord record = QuadRecord::unpack({ quad_data[i * QUAD_RECORD_WORDS], quad_data[i * QUAD_RECORD_WORDS + 1] });
+        glm::vec3 offset = quad_center(record) - camera_pos;
+        keys[i] = { glm::dot(offset, offset), static_cast<uint32_t>(i) };
+    }
+
+    // ties keep the previous order so that equally far quads do not swap on every sort
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        std::stable_sort(keys.begin() + sections[section_index], keys.begin() + sections[section_index + 1],
+                         [](const SortKey& a, const SortKey& b) { return a.distance_squared > b.distance_squared; });
+    }
+
+    std::vector<uint32_t> sorted;
+    sorted.reserve(quad_data.size());
+    for (const SortKey& key : keys) {
+        auto first_word = quad_data.begin() + key.quad * QUAD_RECORD_WORDS;
+        sorted.insert(sorted.end(), first_word, first_word + QUAD_RECORD_WORDS);
+    }
+    quad_data = std::move(sorted);
+}
+
+void TranslucencySorter::submit(SortJob job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // looked up by chunk rather than searched for, since every loaded chunk is submitted at once when the camera
+        // enters another block
+        glm::ivec2 chunk_coords = job.chunk_coords;
+        if (queued_jobs.insert_or_assign(chunk_coords, std::move(job)).second) {
+            job_order.push_back(chunk_coords);
+        }
+    }
+    job_available.notify_one();
+}
+
+std::vector<SortResult> TranslucencySorter::take_results() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::exchange(results, {});
+}
+
+void TranslucencySorter::wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    jobs_finished.wait(lock, [this]() { return job_order.empty() && !sorting; });
+}
+
+void TranslucencySorter::worker_loop() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        job_available.wait(lock, [this]() { return stopping || !job_order.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        auto queued = queued_jobs.find(job_order.front());
+        SortJob job = std::move(queued->second);
+        queued_jobs.erase(queued);
+        job_order.pop_front();
+        sorting = true;
+        lock.unlock();
+
+        sort_back_to_front(job.quad_data, job.sections, job.camera_pos);
+
+        lock.lock();
+        results.push_back({ job.chunk_coords, job.version, std::move(job.quad_data) });
+        sorting = false;
+        bool finished = job_order.empty();
+        lock.unlock();
+
+        if (finished) {
+            jobs_finished.notify_all();
+        }
+    }
+}
@@ -51,6 +51,12 @@ void EventManager::queue_input_event(Event event) {
                 case GLFW_KEY_R:
                     queue_event(Event::make_event(ApplicationEvent::Type::ReloadShaders));
                     break;
+                case GLFW_KEY_G:
+                    queue_event(Event::make_event(ApplicationEvent::Type::ToggleMeshingMode));
+                    break;
+                case GLFW_KEY_F3:
+                    queue_event(Event::make_event(ApplicationEvent::Type::ToggleRenderStats));
+                    break;
                 default:
                     break;
             }
@@ -0,0 +1,107 @@
+#include "graphics/buffer_allocator.hpp"
+
+#include "utils/assert.hpp"
+
+BufferAllocator::BufferAllocator(size_t capacity) : capacity(capacity) {
+    if (capacity > 0) {
+        add_free_range(0, capacity);
+    }
+}
+
+std::optional<BufferRange> BufferAllocator::allocate(size_t size) {
+    if (size == 0) {
+        return BufferRange{};
+    }
+
+    auto best_fit = free_by_size.lower_bound({ size, 0 });
+    if (best_fit == free_by_size.end()) {
+        return std::nullopt;
+    }
+
+    auto [free_size, offset] = *best_fit;
+    remove_free_range(free_by_offset.find(offset));
+
+    // the remainder stays free
+    if (free_size > size) {
+        add_free_range(offset + size, free_size - size);
+    }
+
+    used += size;
+    n_allocations++;
+    return BufferRange{ offset, size };
+}
+
+void BufferAllocator::free(BufferRange range) {
+    if (range.size == 0) {
+        return;
+    }
+    debug_assert(range.offset + range.size <= capacity, "Freeing a range outside of the buffer");
+
+    size_t offset = range.offset;
+    size_t size = range.size;
+
+    // merge with the free range right after
+    auto next = free_by_offset.lower_bound(offset);
+    if (next != free_by_offset.end()) {
+        debug_assert(next->first >= offset + size, "Freeing a range that is already free");
+        if (next->first == offset + size) {
+            size += next->second;
+            remove_free_range(next);
+        }
+    }
+
+    // and with the one right before
+    auto previous = free_by_offset.lower_bound(offset);
+    if (previous != free_by_offset.begin()) {
+        previous--;
+        debug_assert(previous->first + previous->second <= offset, "Freeing a range that is already free");
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            remove_free_range(previous);
+        }
+    }
+
+    add_free_range(offset, size);
+    used -= range.size;
+    n_allocations--;
+}
+
+void BufferAllocator::grow(size_t new_capacity) {
+    debug_assert(new_capacity >= capacity, "Buffers can only grow");
+    if (new_capacity == capacity) {
+        return;
+    }
+
+    size_t old_capacity = capacity;
+    capacity = new_capacity;
+
+    // freeing the new space as if it had been allocated merges it with a free range at the old end
+    used += new_capacity - old_capacity;
+    n_allocations++;
+    free({ old_capacity, new_capacity - old_capacity });
+}
+
+size_t BufferAllocator::get_capacity() const {
+    return capacity;
+}
+
+BufferAllocatorStats BufferAllocator::get_stats() const {
+    return BufferAllocatorStats{
+        capacity,
+        used,
+        n_allocations,
+        free_by_offset.size(),
+        free_by_size.empty() ? 0 : free_by_size.rbegin()->first,
+    };
+}
+
+void BufferAllocator::add_free_range(size_t offset, size_t size) {
+    free_by_offset.insert({ offset, size });
+    free_by_size.insert({ size, offset });
+}
+
+void BufferAllocator::remove_free_range(std::map<size_t, size_t>::iterator it) {
+    free_by_size.erase({ it->second, it->first });
+    free_by_offset.erase(it);
+}
@@ -0,0 +1,63 @@
+#include "graphics/draw_indirect_buffer.hpp"
+
+#include "utils/assert.hpp"
+
+DrawIndirectBuffer::~DrawIndirectBuffer() {
+    destroy();
+}
+
+void DrawIndirectBuffer::destroy() {
+    if (command_buffer) {
+        glDeleteBuffers(1, &command_buffer);
+        glDeleteBuffers(1, &draw_data_buffer);
+    }
+
+    command_buffer = 0;
+    draw_data_buffer = 0;
+}
+
+void DrawIndirectBuffer::clear() {
+    commands.clear();
+    origins.clear();
+}
+
+void DrawIndirectBuffer::add(const RenderCall& render_call, int layer) {
+    debug_assert(commands.empty() || render_call.VAO == VAO, "Indirect draws must share a VAO");
+    VAO = render_call.VAO;
+
+    commands.push_back({
+        static_cast<GLuint>(render_call.n_indices),
+        1,
+        0,
+        static_cast<GLint>(render_call.first_vertex),
+        0,
+    });
+    origins.emplace_back(render_call.origin, static_cast<float>(layer));
+}
+
+void DrawIndirectBuffer::draw() {
+    if (commands.empty()) {
+        return;
+    }
+
+    // the buffers are created on first use so that they can be constructed before the GL context
+    if (!command_buffer) {
+        glGenBuffers(1, &command_buffer);
+        glGenBuffers(1, &draw_data_buffer);
+    }
+
+    // respecifying the whole store every frame lets the driver hand out fresh memory instead of waiting for the
+    // previous frame's draws to finish reading it
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, draw_data_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, origins.size() * sizeof(glm::vec4), origins.data(), GL_STREAM_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_DATA_BINDING, draw_data_buffer);
+
+    glBindVertexArray(VAO);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(commands.size()), 0);
+}
+
+size_t DrawIndirectBuffer::size() const {
+    return commands.size();
+}
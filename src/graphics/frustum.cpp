@@ -0,0 +1,108 @@
+#include "graphics/frustum.hpp"
+
+#include <limits>
+
+// Gribb & Hartmann plane extraction https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+Frustum::Frustum(const glm::mat4& view_projection) {
+    // glm matrices are column major, so row i is made of element i of every column
+    auto row = [&view_projection](int i) {
+        return glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+    };
+
+    planes = {
+        row(3) + row(0), // left
+        row(3) - row(0), // right
+        row(3) + row(1), // bottom
+        row(3) - row(1), // top
+        row(3) + row(2), // near
+        row(3) - row(2), // far
+    };
+}
+
+bool Frustum::intersects_aabb(glm::vec3 min, glm::vec3 max) const {
+    for (const glm::vec4& plane : planes) {
+        // the corner furthest along the plane normal is the last one to leave the inside
+        glm::vec3 positive_corner(plane.x >= 0.0f ? max.x : min.x,
+                                  plane.y >= 0.0f ? max.y : min.y,
+                                  plane.z >= 0.0f ? max.z : min.z);
+
+        if (glm::dot(glm::vec3(plane), positive_corner) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t Frustum::cull(const AABBBatch& boxes, std::vector<uint32_t>& visible) const {
+    size_t n_padded = boxes.center_x.size();
+    visible.assign(n_padded, 1);
+
+    const float* center_x = boxes.center_x.data();
+    const float* center_y = boxes.center_y.data();
+    const float* center_z = boxes.center_z.data();
+    const float* extent_x = boxes.extent_x.data();
+    const float* extent_y = boxes.extent_y.data();
+    const float* extent_z = boxes.extent_z.data();
+    // 32-bit results line up with the float lanes and cannot alias the box arrays
+    uint32_t* result = visible.data();
+
+    for (const glm::vec4& plane : planes) {
+        // the distance of the positive corner is the distance of the center plus the extents projected on the
+        // absolute normal, which needs no per box branch
+        glm::vec3 abs_normal = glm::abs(glm::vec3(plane));
+
+        // fixed size inner loops are vectorized even where the optimizer will not add a scalar remainder loop
+        for (size_t block = 0; block < n_padded; block += AABBBatch::LANES) {
+            for (size_t i = block; i < block + AABBBatch::LANES; i++) {
+                float distance = plane.x * center_x[i] + plane.y * center_y[i] + plane.z * center_z[i] + plane.w
+                    + abs_normal.x * extent_x[i] + abs_normal.y * extent_y[i] + abs_normal.z * extent_z[i];
+                result[i] &= static_cast<uint32_t>(distance >= 0.0f);
+            }
+        }
+    }
+
+    visible.resize(boxes.size());
+
+    size_t n_visible = 0;
+    for (uint32_t box_visible : visible) {
+        n_visible += box_visible;
+    }
+    return n_visible;
+}
+
+void AABBBatch::add(const AABB& box) {
+    // replace the first padding box, or start a new block of padding
+    if (n_boxes == center_x.size()) {
+        center_x.resize(n_boxes + LANES, std::numeric_limits<float>::quiet_NaN());
+        center_y.resize(n_boxes + LANES, std::numeric_limits<float>::quiet_NaN());
+        center_z.resize(n_boxes + LANES, std::numeric_limits<float>::quiet_NaN());
+        extent_x.resize(n_boxes + LANES, 0.0f);
+        extent_y.resize(n_boxes + LANES, 0.0f);
+        extent_z.resize(n_boxes + LANES, 0.0f);
+    }
+
+    glm::vec3 center = (box.min + box.max) * 0.5f;
+    glm::vec3 extent = (box.max - box.min) * 0.5f;
+    center_x[n_boxes] = center.x;
+    center_y[n_boxes] = center.y;
+    center_z[n_boxes] = center.z;
+    extent_x[n_boxes] = extent.x;
+    extent_y[n_boxes] = extent.y;
+    extent_z[n_boxes] = extent.z;
+    n_boxes++;
+}
+
+void AABBBatch::clear() {
+    center_x.clear();
+    center_y.clear();
+    center_z.clear();
+    extent_x.clear();
+    extent_y.clear();
+    extent_z.clear();
+    n_boxes = 0;
+}
+
+size_t AABBBatch::size() const {
+    return n_boxes;
+}
@@ -0,0 +1,107 @@
+#include "graphics/shader_program.hpp"
+
+#include "graphics/shader.hpp"
+#include "utils/logger.hpp"
+
+#include <optional>
+#include <utility>
+
+ShaderProgram::ShaderProgram(std::filesystem::path vertex_path, std::filesystem::path fragment_path)
+    : vertex_path(std::move(vertex_path)), fragment_path(std::move(fragment_path)) {}
+
+ShaderProgram::ShaderProgram(std::filesystem::path vertex_path,
+                             std::filesystem::path fragment_path,
+                             std::filesystem::path geometry_path)
+    : vertex_path(std::move(vertex_path)), fragment_path(std::move(fragment_path)), geometry_path(std::move(geometry_path)) {}
+
+ShaderProgram::~ShaderProgram() {
+    destroy();
+}
+
+void ShaderProgram::destroy() {
+    if (program_id) {
+        glDeleteProgram(program_id);
+    }
+
+    program_id = 0;
+}
+
+bool ShaderProgram::load() {
+    std::optional<GLuint> new_program = geometry_path.empty()
+        ? Shader::create(vertex_path, fragment_path)
+        : Shader::create(vertex_path, fragment_path, geometry_path);
+
+    if (!new_program) {
+        return false;
+    }
+
+    if (program_id) {
+        glDeleteProgram(program_id);
+    }
+    program_id = *new_program;
+    for (size_t i = 0; i < uniform_names.size(); i++) {
+        resolve_uniform(i);
+    }
+
+    return true;
+}
+
+void ShaderProgram::use() const {
+    glUseProgram(program_id);
+}
+
+GLuint ShaderProgram::id() const {
+    return program_id;
+}
+
+size_t ShaderProgram::add_uniform(const std::string& name) {
+    uniform_names.push_back(name);
+    uniform_locations.push_back(-1);
+    if (program_id) {
+        resolve_uniform(uniform_names.size() - 1);
+    }
+    return uniform_names.size() - 1;
+}
+
+void ShaderProgram::resolve_uniform(size_t index) {
+    uniform_locations[index] = glGetUniformLocation(program_id, uniform_names[index].c_str());
+    if (uniform_locations[index] == -1) {
+        log_debug("Uniform \"%s\" is not used by shader \"%s\"", uniform_names[index].c_str(), vertex_path.c_str());
+    }
+}
+
+void ShaderProgram::set(Uniform<bool> uniform, bool value) const {
+    glUniform1i(uniform_locations[uniform.index], (int)value);
+}
+
+void ShaderProgram::set(Uniform<int> uniform, int value) const {
+    glUniform1i(uniform_locations[uniform.index], value);
+}
+
+void ShaderProgram::set(Uniform<float> uniform, float value) const {
+    glUniform1f(uniform_locations[uniform.index], value);
+}
+
+void ShaderProgram::set(Uniform<glm::vec2> uniform, const glm::vec2& value) const {
+    glUniform2fv(uniform_locations[uniform.index], 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::set(Uniform<glm::vec3> uniform, const glm::vec3& value) const {
+    glUniform3fv(uniform_locations[uniform.index], 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::set(Uniform<glm::vec4> uniform, const glm::vec4& value) const {
+    glUniform4fv(uniform_locations[uniform.index], 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::set(Uniform<glm::mat2> uniform, const glm::mat2& value) const {
+    glUniformMatrix2fv(uniform_locations[uniform.index], 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void ShaderProgram::set(Uniform<glm::mat3> uniform, const glm::mat3& value) const {
+    glUniformMatrix3fv(uniform_locations[uniform.index], 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void ShaderProgram::set(Uniform<glm::mat4> uniform, const glm::mat4& value) const {
+    glUniformMatrix4fv(uniform_locations[uniform.index], 1, GL_FALSE, glm::value_ptr(value));
+}
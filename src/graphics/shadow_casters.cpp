@@ -0,0 +1,34 @@
+#include "graphics/shadow_casters.hpp"
+
+void ShadowCasterSelection::select(const std::vector<glm::mat4>& light_matrices, int cascade_mask, const AABBBatch& caster_bounds) {
+    cascade_casters.resize(light_matrices.size());
+
+    for (size_t i = 0; i < light_matrices.size(); i++) {
+        std::vector<uint32_t>& casters = cascade_casters[i];
+        casters.clear();
+        if (((cascade_mask >> i) & 1) == 0) {
+            continue;
+        }
+
+        // an orthographic light matrix gives the six faces of the cascade's box as frustum planes
+        size_t n_visible = Frustum(light_matrices[i]).cull(caster_bounds, visibility);
+        casters.reserve(n_visible);
+        for (size_t j = 0; j < caster_bounds.size(); j++) {
+            if (visibility[j]) {
+                casters.push_back(static_cast<uint32_t>(j));
+            }
+        }
+    }
+}
+
+const std::vector<uint32_t>& ShadowCasterSelection::get_casters(int cascade_index) const {
+    return cascade_casters[cascade_index];
+}
+
+size_t ShadowCasterSelection::total_casters() const {
+    size_t total = 0;
+    for (const std::vector<uint32_t>& casters : cascade_casters) {
+        total += casters.size();
+    }
+    return total;
+}
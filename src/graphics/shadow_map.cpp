@@ -1,10 +1,11 @@
 #include "graphics/shadow_map.hpp"
 
-#include "graphics/shader.hpp"
+#include "blocks/common.hpp"
 #include "graphics/texture.hpp"
 #include "utils/assert.hpp"
 #include "utils/logger.hpp"
 
+#include <algorithm>
 #include <cmath>
 
 ShadowMap::ShadowMap(int width, int height, CameraSystem* camera_system) : width(width), height(height), camera_system(camera_system) {
@@ -31,8 +32,11 @@ ShadowMap::ShadowMap(int width, int height, CameraSystem* camera_system) : width
     glReadBuffer(GL_NONE);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    this->depth_shader = Shader::create("data/shaders/depth.vert", "data/shaders/depth.frag", "data/shaders/depth.geom").value_or(0);
-    debug_assert(depth_shader != 0, "Error creating depth shader for shadow map");
+    bool depth_shader_loaded = depth_shader.load();
+    debug_assert(depth_shader_loaded, "Error creating depth shader for shadow map");
+
+    layered_rendering = GLAD_GL_ARB_shader_viewport_layer_array || GLAD_GL_AMD_vertex_shader_layer;
+    log_debug("Shadow cascades drawn %s", layered_rendering ? "in one layered pass" : "one pass per cascade");
 
     this->light_pos = glm::normalize(glm::vec3(10.0f, 20.0f, 50.0f));
 
@@ -58,36 +62,134 @@ ShadowMap::ShadowMap(int width, int height, CameraSystem* camera_system) : width
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
-void ShadowMap::shadow_pass(const std::vector<RenderCall>& render_queue) {
+ShadowMap::~ShadowMap() {
+    glDeleteBuffers(1, &matrices_UBO);
+    glDeleteFramebuffers(1, &FBO);
+    glDeleteTextures(1, &texture_id);
+}
+
+void ShadowMap::shadow_pass(const std::vector<RenderCall>& render_queue, const AABBBatch& caster_bounds) {
+    debug_assert(caster_bounds.size() == render_queue.size(), "Shadow caster bounds do not match the render queue");
+
+    std::vector<glm::mat4> light_matrices = get_light_matrices();
+
+    // near cascades are redrawn as soon as they are stale, far ones take turns, and never drawn ones are drawn
+    // right away since there is nothing cached to sample from
+    std::array<bool, CASCADE_LEVELS> stale{};
+    std::array<bool, CASCADE_LEVELS> update{};
+    for (int i = 0; i < CASCADE_LEVELS; i++) {
+        stale[i] = cascade_dirty[i] || light_matrices[i] != cascade_matrices[i];
+        update[i] = !cascade_drawn[i] || (i < FIRST_ROUND_ROBIN_CASCADE && stale[i]);
+    }
+    for (int j = 0; j < CASCADE_LEVELS - FIRST_ROUND_ROBIN_CASCADE; j++) {
+        int i = FIRST_ROUND_ROBIN_CASCADE + (next_round_robin_cascade - FIRST_ROUND_ROBIN_CASCADE + j) % (CASCADE_LEVELS - FIRST_ROUND_ROBIN_CASCADE);
+        if (stale[i] && cascade_drawn[i]) {
+            update[i] = true;
+            next_round_robin_cascade = i + 1 < CASCADE_LEVELS ? i + 1 : FIRST_ROUND_ROBIN_CASCADE;
+            break;
+        }
+    }
+
+    int cascade_mask = 0;
+    for (int i = 0; i < CASCADE_LEVELS; i++) {
+        cascade_mask |= update[i] << i;
+    }
+
+    culling_stats = {};
+    if (cascade_mask == 0) {
+        return;
+    }
+
+    caster_selection.select(light_matrices, cascade_mask, caster_bounds);
+
     // switch to depth framebuffer and change viewport to shadow map dimensions
-    glUseProgram(depth_shader);
+    depth_shader.use();
     glEnable(GL_DEPTH_TEST);
     glViewport(0, 0, this->width, this->height);
     glBindFramebuffer(GL_FRAMEBUFFER, this->FBO);
-    glClear(GL_DEPTH_BUFFER_BIT);
     glActiveTexture(GL_TEXTURE0 + this->texture_unit);
 
-    std::vector<glm::mat4> light_matrices = get_light_matrices();
-
-    // send light matrices to UBO
+    // only the redrawn layers are cleared and get new matrices, the others keep the ones they were drawn with
+    float clear_depth = 1.0f;
     glBindBuffer(GL_UNIFORM_BUFFER, matrices_UBO);
-    for (size_t i = 0; i < CASCADE_LEVELS; ++i) {
+    for (int i = 0; i < CASCADE_LEVELS; i++) {
+        if (!update[i]) {
+            continue;
+        }
+
+        glClearTexSubImage(texture_id, 0, 0, 0, i, width, height, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &clear_depth);
         glBufferSubData(GL_UNIFORM_BUFFER, i * sizeof(glm::mat4x4), sizeof(glm::mat4x4), &light_matrices[i]);
+        cascade_matrices[i] = light_matrices[i];
+        cascade_drawn[i] = true;
+        cascade_dirty[i] = false;
+        cascade_update_counts[i]++;
+
+        cascade_caster_counts[i] = caster_selection.get_casters(i).size();
+        culling_stats.drawn += cascade_caster_counts[i];
+        culling_stats.culled += render_queue.size() - cascade_caster_counts[i];
     }
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
-    for (const RenderCall& render_call : render_queue) {
-        Shader::set_uniform(depth_shader, "model", render_call.transform);
-        glBindVertexArray(render_call.VAO);
-        glDrawArrays(GL_TRIANGLES, 0, render_call.n_vertices);
+    // the depth shader reads the cascade of each draw from the draw data and sets gl_Layer to it when it can
+    if (layered_rendering) {
+        draw_buffer.clear();
+        for (int i = 0; i < CASCADE_LEVELS; i++) {
+            for (uint32_t caster : caster_selection.get_casters(i)) {
+                draw_buffer.add(render_queue[caster], i);
+            }
+        }
+        draw_buffer.draw();
+    } else {
+        for (int i = 0; i < CASCADE_LEVELS; i++) {
+            if (!update[i]) {
+                continue;
+            }
+
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture_id, 0, i);
+            draw_buffer.clear();
+            for (uint32_t caster : caster_selection.get_casters(i)) {
+                draw_buffer.add(render_queue[caster], i);
+            }
+            draw_buffer.draw();
+        }
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void ShadowMap::invalidate(const AABB& bounds) {
+    for (int i = 0; i < CASCADE_LEVELS; i++) {
+        if (cascade_drawn[i] && Frustum(cascade_matrices[i]).intersects_aabb(bounds.min, bounds.max)) {
+            cascade_dirty[i] = true;
+        }
+    }
+}
+
+bool ShadowMap::reload_shader() {
+    if (!depth_shader.load()) {
+        return false;
+    }
+
+    // the cached cascades were drawn by the previous program
+    cascade_drawn.fill(false);
+    return true;
+}
+
 GLuint ShadowMap::get_unit() const {
     return this->texture_unit;
 }
 
+CullingStats ShadowMap::get_culling_stats() const {
+    return culling_stats;
+}
+
+size_t ShadowMap::get_cascade_caster_count(int cascade_index) const {
+    return cascade_caster_counts[cascade_index];
+}
+
+size_t ShadowMap::get_cascade_update_count(int cascade_index) const {
+    return cascade_update_counts[cascade_index];
+}
+
 // converts [-1, 1]^3 NDC cube to frustum corner coordinates in world space
 std::vector<glm::vec4> ShadowMap::get_frustum_corners_world_space(const glm::mat4& proj, const glm::mat4& view) const {
     glm::mat4 inverse = glm::inverse(proj * view);
@@ -116,61 +218,30 @@ glm::mat4 ShadowMap::get_light_matrix(float near_plane, float far_plane) const {
     }
     center /= 8.0f;
 
-    glm::mat4 light_view = glm::lookAt(center + light_pos, center, glm::vec3(0.0f, 0.0f, 1.0f));
-
-    // find AABB for frustum
-    float min_x = std::numeric_limits<float>::max();
-    float max_x = std::numeric_limits<float>::lowest();
-    float min_y = std::numeric_limits<float>::max();
-    float max_y = std::numeric_limits<float>::lowest();
-    float min_z = std::numeric_limits<float>::max();
-    float max_z = std::numeric_limits<float>::lowest();
+    // the bounding sphere of the frustum slice keeps its size when the camera turns or moves, and so does the
+    // size of a shadow texel. Rounded up so that float error cannot change it either
+    float radius = 0.0f;
     for (const auto& v : corners) {
-        const auto corner_light_space = light_view * v;
-        min_x = std::min(min_x, corner_light_space.x);
-        max_x = std::max(max_x, corner_light_space.x);
-        min_y = std::min(min_y, corner_light_space.y);
-        max_y = std::max(max_y, corner_light_space.y);
-        min_z = std::min(min_z, corner_light_space.z);
-        max_z = std::max(max_z, corner_light_space.z);
+        radius = std::max(radius, glm::length(glm::vec3(v) - center));
     }
+    radius = std::ceil(radius);
 
-    // allow geometry beyond frustum to cast shadows
-    constexpr float x_mult = 2.0f;
-    if (min_x < 0) {
-        min_x *= x_mult;
-    } else {
-        min_x /= x_mult;
-    }
-    if (max_x < 0) {
-        max_x /= x_mult;
-    } else {
-        max_x *= x_mult;
-    }
-    constexpr float y_mult = 2.0f;
-    if (min_y < 0) {
-        min_y *= y_mult;
-    } else {
-        min_y /= y_mult;
-    }
-    if (max_y < 0) {
-        max_y /= y_mult;
-    } else {
-        max_y *= y_mult;
-    }
-    constexpr float z_mult = 5.0f;
-    if (min_z < 0) {
-        min_z *= z_mult;
-    } else {
-        min_z /= z_mult;
-    }
-    if (max_z < 0) {
-        max_z /= z_mult;
-    } else {
-        max_z *= z_mult;
-    }
+    // looking at the origin rather than the center, so that moving the camera only translates the cascade in
+    // light space
+    glm::mat4 light_view = glm::lookAt(light_pos, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::vec3 light_center = glm::vec3(light_view * glm::vec4(center, 1.0f));
+
+    // moving in whole texel steps makes static geometry always land on the same texels, which stops shadow edges
+    // from shimmering and gives an unchanged matrix, and a cached cascade, while the camera stays in one texel
+    glm::vec3 texel_size(2.0f * radius / width, 2.0f * radius / height, 2.0f * radius / width);
+    light_center = glm::floor(light_center / texel_size) * texel_size;
 
-    glm::mat4 light_proj = glm::ortho(min_x, max_x, min_y, max_y, min_z, max_z);
+    // allow geometry beyond frustum to cast shadows: everything between the slice and the top of the world along
+    // the light direction. The light looks down -z in its view space
+    float caster_distance = CHUNK_HEIGHT / std::max(light_pos.z, 0.1f);
+    glm::mat4 light_proj = glm::ortho(light_center.x - radius, light_center.x + radius,
+                                      light_center.y - radius, light_center.y + radius,
+                                      -(light_center.z + radius + caster_distance), -(light_center.z - radius));
     return light_proj * light_view;
 }
 
@@ -0,0 +1,123 @@
+#include "networking/chunk_service.hpp"
+
+#include <algorithm>
+#include <utility>
+
+ChunkService::ChunkService(size_t cache_budget, int num_threads) : chunk_store(cache_budget) {
+    for (int i = 0; i < std::max(num_threads, 1); i++) {
+        workers.emplace_back(&ChunkService::worker_loop, this);
+    }
+}
+
+ChunkService::~ChunkService() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+        far_terrain_jobs.clear();
+    }
+    job_available.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+int ChunkService::default_num_threads(int num_network_threads) {
+    int hardware_threads = static_cast<int>(std::thread::hardware_concurrency());
+    return std::max(hardware_threads - num_network_threads, 1);
+}
+
+void ChunkService::request(std::shared_ptr<Session> session, const ChunkRequest& request) {
+    ChunkStore::Key key{ request.chunk_coords, request.seed };
+
+    std::unique_lock<std::mutex> lock(mutex);
+    auto waiting = waiting_sessions.find(key);
+    if (waiting != waiting_sessions.end()) {
+        waiting->second.push_back(std::move(session));
+        n_coalesced++;
+        return;
+    }
+
+    std::optional<Packet> packet = chunk_store.find_packet(key.chunk_coords, key.seed);
+    if (packet) {
+        lock.unlock();
+        session->send(std::move(*packet));
+        return;
+    }
+
+    waiting_sessions[key].push_back(std::move(session));
+    jobs.push_back(key);
+    lock.unlock();
+    job_available.notify_one();
+}
+
+void ChunkService::request_far_terrain(std::shared_ptr<Session> session, const FarTerrainRequest& request) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        far_terrain_jobs.push_back({ std::move(session), request });
+    }
+    job_available.notify_one();
+}
+
+ChunkServiceStats ChunkService::get_stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return {
+        chunk_store.get_stats(),
+        chunk_store.size(),
+        chunk_store.get_memory_usage(),
+        chunk_store.get_memory_budget(),
+        n_coalesced,
+        waiting_sessions.size(),
+        far_terrain_jobs.size(),
+    };
+}
+
+void ChunkService::worker_loop() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        job_available.wait(lock, [this]() { return stopping || !jobs.empty() || !far_terrain_jobs.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        if (!jobs.empty()) {
+            ChunkStore::Key key = jobs.front();
+            jobs.pop_front();
+            lock.unlock();
+            generate_chunk(key);
+        } else {
+            FarTerrainJob job = std::move(far_terrain_jobs.front());
+            far_terrain_jobs.pop_front();
+            lock.unlock();
+            generate_far_tile(std::move(job));
+        }
+    }
+}
+
+void ChunkService::generate_chunk(ChunkStore::Key key) {
+    Chunk chunk(key.chunk_coords, key.seed);
+    chunk.generate_blocks_from_seed();
+    Packet packet = ChunkData{ key.chunk_coords, key.seed, chunk.get_blocks() }.serialize();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    chunk_store.insert(std::move(chunk), packet);
+    auto waiting = waiting_sessions.extract(key);
+    lock.unlock();
+
+    // sessions are only used from their own executor
+    for (std::shared_ptr<Session>& session : waiting.mapped()) {
+        asio::post(session->get_executor(), [session, packet]() mutable {
+            session->send(std::move(packet));
+        });
+    }
+}
+
+void ChunkService::generate_far_tile(FarTerrainJob job) {
+    Packet packet = FarTerrainData::generate(job.request.tile_coords, job.request.seed).serialize();
+
+    std::shared_ptr<Session> session = std::move(job.session);
+    asio::post(session->get_executor(), [session, packet = std::move(packet)]() mutable {
+        session->send(std::move(packet));
+    });
+}
@@ -1,6 +1,10 @@
 #include "networking/server.hpp"
 #include "utils/logger.hpp"
 
+#include <algorithm>
+#include <thread>
+#include <vector>
+
 ServerInterface::ServerInterface(uint16_t port)
         : acceptor(io_context, { asio::ip::tcp::v4(), port }) {
     asio::co_spawn(io_context, accept_loop(), asio::detached);
@@ -10,33 +14,82 @@ void ServerInterface::register_packet_handler(PacketType type, PacketHandler han
     handlers[type] = std::move(handler);
 }
 
+void ServerInterface::set_tick_handler(std::chrono::steady_clock::duration interval, TickHandler handler) {
+    tick_interval = interval;
+    tick_handler = std::move(handler);
+}
+
+// Sends right away from the handlers of the session itself, otherwise on its strand
 void ServerInterface::send_to(std::shared_ptr<Session> session, Packet packet) {
-    session->send(std::move(packet));
+    asio::dispatch(session->get_executor(), [session, packet = std::move(packet)]() mutable {
+        session->send(std::move(packet));
+    });
 }
 
 void ServerInterface::broadcast(const Packet& packet, std::shared_ptr<Session> exclude) {
+    std::lock_guard<std::mutex> lock(sessions_mutex);
     for (auto& [id, session] : sessions) {
         if (session != exclude) {
-            session->send(packet);
+            asio::post(session->get_executor(), [session, packet]() mutable {
+                session->send(std::move(packet));
+            });
         }
     }
 }
 
 void ServerInterface::poll() {
+    start_ticks();
     io_context.restart();
     io_context.poll();
 }
 
+void ServerInterface::run(int num_threads) {
+    start_ticks();
+    io_context.restart();
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_threads; i++) {
+        threads.emplace_back([this]() { io_context.run(); });
+    }
+    io_context.run();
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void ServerInterface::stop() {
+    io_context.stop();
+}
+
 size_t ServerInterface::client_count() const {
+    std::lock_guard<std::mutex> lock(sessions_mutex);
     return sessions.size();
 }
 
+int ServerInterface::default_num_threads() {
+    int hardware_threads = static_cast<int>(std::thread::hardware_concurrency());
+    return std::clamp(hardware_threads / 4, 1, MAX_DEFAULT_THREADS);
+}
+
+void ServerInterface::start_ticks() {
+    if (tick_handler && !is_ticking) {
+        is_ticking = true;
+        asio::co_spawn(io_context, tick_loop(), asio::detached);
+    }
+}
+
 asio::awaitable<void> ServerInterface::accept_loop() {
     while (true) {
-        asio::ip::tcp::socket socket = co_await acceptor.async_accept(asio::use_awaitable);
+        // every session gets its own strand, which its reads, writes and handlers run on
+        asio::ip::tcp::socket socket = co_await acceptor.async_accept(asio::make_strand(io_context), asio::use_awaitable);
 
         uint64_t id = next_id++;
         auto session = std::make_shared<Session>(std::move(socket));
+        {
+            std::lock_guard<std::mutex> lock(sessions_mutex);
+            sessions[id] = session;
+        }
 
         // copy endpoint first so we still have it when disconnecting
         auto endpoint = session->remote_endpoint();
@@ -44,14 +97,32 @@ asio::awaitable<void> ServerInterface::accept_loop() {
 
         session->start(
             [this](std::shared_ptr<Session> session, Packet packet){
-                if (handlers.contains(packet.header.type)) {
-                    handlers[packet.header.type](session, packet);
+                auto handler = handlers.find(packet.header.type);
+                if (handler != handlers.end()) {
+                    handler->second(session, std::move(packet));
                 }
             },
-            [this, id, endpoint](std::shared_ptr<Session>) {
-                log_debug("[Server] Client %ld disconnected (%s:%d)", id, endpoint.address().to_string().c_str(), endpoint.port());
+            [this, id, endpoint](std::shared_ptr<Session> session) {
+                const SessionWriteStats& stats = session->get_write_stats();
+                log_debug("[Server] Client %ld disconnected (%s:%d), sent %zu packets (%zu KiB) in %zu batches and %zu writes",
+                          id, endpoint.address().to_string().c_str(), endpoint.port(),
+                          stats.packets, stats.bytes / 1024, stats.batches, stats.writes);
+                std::lock_guard<std::mutex> lock(sessions_mutex);
                 sessions.erase(id);
             }
         );
     }
 }
+
+asio::awaitable<void> ServerInterface::tick_loop() {
+    asio::steady_timer timer(io_context);
+    auto next_tick = std::chrono::steady_clock::now() + tick_interval;
+
+    while (true) {
+        timer.expires_at(next_tick);
+        co_await timer.async_wait(asio::use_awaitable);
+        tick_handler();
+
+        next_tick = std::max(next_tick + tick_interval, std::chrono::steady_clock::now());
+    }
+}
@@ -1,6 +1,9 @@
 #include "networking/session.hpp"
 #include "utils/logger.hpp"
 
+#include <algorithm>
+#include <span>
+
 void Session::start(PacketHandler on_packet, CloseHandler on_close) {
     this->on_packet = std::move(on_packet);
     this->on_close = std::move(on_close);
@@ -8,6 +11,10 @@ void Session::start(PacketHandler on_packet, CloseHandler on_close) {
 }
 
 void Session::send(Packet packet) {
+    if (is_closing) {
+        return;
+    }
+
     write_queue.push_back(std::move(packet));
     if (!is_writing) {
         is_writing = true;
@@ -40,6 +47,14 @@ asio::ip::tcp::endpoint Session::remote_endpoint() const {
     return endpoint;
 }
 
+asio::any_io_executor Session::get_executor() {
+    return socket.get_executor();
+}
+
+const SessionWriteStats& Session::get_write_stats() const {
+    return write_stats;
+}
+
 asio::awaitable<void> Session::read_loop() {
     auto self = shared_from_this();
 
@@ -78,23 +93,51 @@ asio::awaitable<void> Session::read_loop() {
 }
 
 asio::awaitable<void> Session::write_loop() {
+    auto self = shared_from_this();
     asio::error_code ec;
     unsigned long length;
 
     while (!write_queue.empty()) {
-        auto data = write_queue.front().serialize();
-        write_queue.pop_front();
-        std::tie(ec, length) = co_await asio::async_write(socket,
-                                                          asio::buffer(data),
-                                                          asio::as_tuple(asio::use_awaitable));
+        // headers and payloads are written straight from the queued packets, without copying them into one buffer
+        write_batch.swap(write_queue);
+        write_buffers.clear();
+        for (const Packet& packet : write_batch) {
+            write_buffers.push_back(asio::buffer(&packet.header, sizeof(PacketHeader)));
+            if (!packet.payload.empty()) {
+                write_buffers.push_back(asio::buffer(packet.payload));
+            }
+            write_stats.bytes += sizeof(PacketHeader) + packet.payload.size();
+        }
+        write_stats.batches++;
+        write_stats.packets += write_batch.size();
 
-        if (ec) {
-            if (ec != asio::error::eof) {
-                log_error("Error writing packet: %s", ec.message().c_str());
+        // same as asio::async_write, but counting the write_some calls
+        size_t first_buffer = 0;
+        while (first_buffer < write_buffers.size()) {
+            std::tie(ec, length) = co_await socket.async_write_some(std::span(write_buffers).subspan(first_buffer),
+                                                                    asio::as_tuple(asio::use_awaitable));
+            write_stats.writes++;
+
+            if (ec) {
+                if (ec != asio::error::eof) {
+                    log_error("Error writing packet: %s", ec.message().c_str());
+                }
+                write_batch.clear();
+                is_writing = false;
+                close();
+                co_return;
+            }
+
+            while (length > 0) {
+                size_t written = std::min<size_t>(length, write_buffers[first_buffer].size());
+                write_buffers[first_buffer] += written;
+                length -= written;
+                if (write_buffers[first_buffer].size() == 0) {
+                    first_buffer++;
+                }
             }
-            close();
-            break;
         }
+        write_batch.clear();
     }
     is_writing = false;
 }
@@ -0,0 +1,124 @@
+#include "graphics/buffer_allocator.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Free runs of a reference bitmap, where true marks an allocated unit
+struct FreeRuns {
+    size_t count = 0;
+    size_t largest = 0;
+};
+
+static FreeRuns find_free_runs(const std::vector<bool>& allocated) {
+    FreeRuns runs;
+    size_t run = 0;
+    for (size_t i = 0; i <= allocated.size(); i++) {
+        if (i < allocated.size() && !allocated[i]) {
+            run++;
+            continue;
+        }
+        if (run > 0) {
+            runs.count++;
+            runs.largest = std::max(runs.largest, run);
+        }
+        run = 0;
+    }
+    return runs;
+}
+
+// Fully merged free ranges are exactly the free runs of the bitmap
+static bool matches(const BufferAllocator& allocator, const std::vector<bool>& allocated) {
+    BufferAllocatorStats stats = allocator.get_stats();
+    FreeRuns runs = find_free_runs(allocated);
+    size_t used = static_cast<size_t>(std::count(allocated.begin(), allocated.end(), true));
+    return stats.capacity == allocated.size() && stats.used == used && stats.n_free_ranges == runs.count &&
+           stats.largest_free_range == runs.largest;
+}
+
+static void test_best_fit() {
+    BufferAllocator allocator(100);
+    auto a = allocator.allocate(10);
+    auto b = allocator.allocate(30);
+    auto c = allocator.allocate(5);
+    auto d = allocator.allocate(20);
+    check(a && b && c && d, "Allocations that fit succeed");
+    check(a->offset == 0 && b->offset == 10 && c->offset == 40 && d->offset == 45, "Ranges are packed from the start");
+
+    // frees leave holes of 10, 5 and the 35 at the end
+    allocator.free(*a);
+    allocator.free(*c);
+    auto e = allocator.allocate(5);
+    check(e && e->offset == 40, "The smallest hole that fits is used");
+    auto f = allocator.allocate(8);
+    check(f && f->offset == 0, "The next smallest hole that fits is used");
+
+    check(!allocator.allocate(36).has_value(), "An allocation larger than every hole fails");
+    check(allocator.allocate(0).has_value(), "Empty allocations always succeed");
+
+    allocator.grow(200);
+    auto g = allocator.allocate(135);
+    check(g && g->offset == 65, "Growing merges the new space with the free range at the old end");
+}
+
+// random allocations and frees, checked against a bitmap of the buffer
+static void test_random() {
+    std::mt19937 rng(2345);
+    size_t capacity = 4096;
+    BufferAllocator allocator(capacity);
+    std::vector<bool> allocated(capacity, false);
+    std::vector<BufferRange> ranges;
+
+    for (int step = 0; step < 20000; step++) {
+        bool do_free = !ranges.empty() && rng() % 2 == 0;
+        if (do_free) {
+            size_t i = rng() % ranges.size();
+            BufferRange range = ranges[i];
+            ranges[i] = ranges.back();
+            ranges.pop_back();
+
+            allocator.free(range);
+            std::fill(allocated.begin() + range.offset, allocated.begin() + range.offset + range.size, false);
+        } else {
+            size_t size = 1 + rng() % 128;
+            auto range = allocator.allocate(size);
+            if (!range.has_value()) {
+                check(find_free_runs(allocated).largest < size, "Allocation fails only if no free run fits");
+            } else {
+                check(range->size == size && range->offset + range->size <= capacity,
+                      "Allocated ranges lie within the buffer");
+                bool overlaps = std::any_of(allocated.begin() + range->offset,
+                                            allocated.begin() + range->offset + range->size,
+                                            [](bool unit) { return unit; });
+                check(!overlaps, "Allocated ranges do not overlap");
+                std::fill(allocated.begin() + range->offset, allocated.begin() + range->offset + range->size, true);
+                ranges.push_back(*range);
+            }
+        }
+
+        if (step % 1000 == 999 && capacity < 16384) {
+            capacity += 1024;
+            allocator.grow(capacity);
+            allocated.resize(capacity, false);
+        }
+
+        if (!matches(allocator, allocated)) {
+            check(false, "Allocator stats do not match the reference bitmap after step " + std::to_string(step));
+            return;
+        }
+    }
+
+    for (BufferRange range : ranges) {
+        allocator.free(range);
+    }
+    BufferAllocatorStats stats = allocator.get_stats();
+    check(stats.used == 0 && stats.n_allocations == 0, "Freeing every range leaves the buffer empty");
+    check(stats.n_free_ranges == 1 && stats.largest_free_range == capacity, "Freeing every range merges them all");
+}
+
+int main() {
+    test_best_fit();
+    test_random();
+    return check_result();
+}
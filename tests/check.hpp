@@ -0,0 +1,24 @@
+#pragma once
+
+#include "utils/logger.hpp"
+
+#include <cstdio>
+
+// Tests are plain executables: a failed check prints where it failed and the test keeps going, then check_result
+// gives the exit code for ctest
+inline int n_failed_checks = 0;
+
+inline void check(bool condition, string_with_loc message) {
+    if (!condition) {
+        std::fprintf(stderr, "[CHECK FAILED] (%s:%u) %s\n", message.loc.file_name(), message.loc.line(), message.msg.c_str());
+        n_failed_checks++;
+    }
+}
+
+inline int check_result() {
+    if (n_failed_checks > 0) {
+        std::fprintf(stderr, "%d checks failed\n", n_failed_checks);
+        return 1;
+    }
+    return 0;
+}
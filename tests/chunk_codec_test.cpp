@@ -0,0 +1,183 @@
+#include "blocks/block_layout.hpp"
+#include "blocks/chunk.hpp"
+#include "blocks/chunk_codec.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+static std::vector<Block> generated_blocks(glm::ivec2 chunk_coords) {
+    Chunk chunk(chunk_coords, 2345);
+    chunk.generate_blocks_from_seed();
+    return chunk.get_blocks();
+}
+
+static bool same_types(const std::vector<Block>& a, const std::vector<Block>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](Block x, Block y) { return x.type == y.type; });
+}
+
+static std::optional<std::vector<Block>> decode(const std::vector<std::byte>& encoded) {
+    return decode_chunk_blocks(encoded.data(), encoded.size());
+}
+
+static std::vector<std::byte> bytes(std::initializer_list<int> values) {
+    std::vector<std::byte> result;
+    for (int value : values) {
+        result.push_back(static_cast<std::byte>(value));
+    }
+    return result;
+}
+
+// An uncompressed encoding whose first section is given and whose other sections are uniform air
+static std::vector<std::byte> with_first_section(const std::vector<std::byte>& section) {
+    std::vector<std::byte> encoded = bytes({ CHUNK_ENCODING_VERSION, 0 });
+    encoded.insert(encoded.end(), section.begin(), section.end());
+    for (int section_index = 1; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        encoded.push_back(std::byte{ 1 });
+        encoded.push_back(static_cast<std::byte>(Block::Type::AIR));
+    }
+    return encoded;
+}
+
+// A first section of stone below air: a palette of the two and one run of each per column
+static std::vector<std::byte> two_run_section(int first_run_length, int second_run_length) {
+    std::vector<std::byte> section = bytes({ 2, Block::Type::STONE, Block::Type::AIR });
+    for (int column = 0; column < CHUNK_LENGTH * CHUNK_WIDTH; column++) {
+        section.push_back(static_cast<std::byte>(0 << 4 | (first_run_length - 1)));
+        section.push_back(static_cast<std::byte>(1 << 4 | (second_run_length - 1)));
+    }
+    return section;
+}
+
+static void test_round_trip() {
+    for (glm::ivec2 chunk_coords : { glm::ivec2(0, 0), glm::ivec2(-5, 3), glm::ivec2(17, -9) }) {
+        std::vector<Block> blocks = generated_blocks(chunk_coords);
+        for (bool compress : { false, true }) {
+            std::optional<std::vector<Block>> decoded = decode(encode_chunk_blocks(blocks, compress));
+            check(decoded && same_types(*decoded, blocks), "Generated chunks round trip");
+        }
+    }
+
+    std::optional<std::vector<Block>> stone_below_air = decode(with_first_section(two_run_section(4, 12)));
+    check(stone_below_air && (*stone_below_air)[LinearLayout::index(0, 0, 3)].type == Block::Type::STONE &&
+              (*stone_below_air)[LinearLayout::index(0, 0, 4)].type == Block::Type::AIR,
+          "A hand written encoding decodes");
+}
+
+static void test_malformed_chunks() {
+    std::vector<Block> blocks = generated_blocks({ 0, 0 });
+    for (bool compress : { false, true }) {
+        std::vector<std::byte> encoded = encode_chunk_blocks(blocks, compress);
+        check(!decode_chunk_blocks(encoded.data(), encoded.size() - 1).has_value(), "Truncated bodies are rejected");
+        check(!decode_chunk_blocks(encoded.data(), 1).has_value(), "Truncated headers are rejected");
+
+        encoded.push_back(std::byte{ 0 });
+        check(!decode(encoded).has_value(), "Trailing bytes are rejected");
+    }
+
+    std::vector<std::byte> other_version = encode_chunk_blocks(blocks, false);
+    other_version[0] = static_cast<std::byte>(CHUNK_ENCODING_VERSION + 1);
+    check(!decode(other_version).has_value(), "Other versions are rejected");
+
+    std::vector<std::byte> bad_palette_index = two_run_section(4, 12);
+    bad_palette_index[3] = static_cast<std::byte>(2 << 4 | 3);
+    check(!decode(with_first_section(bad_palette_index)).has_value(),
+          "Runs indexing past the palette are rejected");
+
+    std::vector<std::byte> bad_block_type = two_run_section(4, 12);
+    bad_block_type[2] = static_cast<std::byte>(Block::Type::SIZE);
+    check(!decode(with_first_section(bad_block_type)).has_value(), "Palettes with unknown block types are rejected");
+
+    check(!decode(with_first_section(two_run_section(4, 13))).has_value(),
+          "Runs going past the top of the section are rejected");
+    check(!decode(with_first_section(bytes({ 0 }))).has_value(), "Empty palettes are rejected");
+}
+
+static void test_malformed_compressed_chunks() {
+    std::vector<std::byte> encoded = encode_chunk_blocks(generated_blocks({ 0, 0 }), true);
+    check(static_cast<uint8_t>(encoded[1]) & CHUNK_ENCODING_LZ, "Generated chunks are compressed");
+
+    uint32_t raw_size{};
+    std::memcpy(&raw_size, encoded.data() + 2, sizeof(raw_size));
+    for (uint32_t wrong_size : { raw_size + 1, raw_size - 1, UINT32_MAX }) {
+        std::vector<std::byte> resized = encoded;
+        std::memcpy(resized.data() + 2, &wrong_size, sizeof(wrong_size));
+        check(!decode(resized).has_value(), "A raw size other than the decompressed size is rejected");
+    }
+}
+
+static void test_lz() {
+    std::vector<std::byte> input;
+    for (int i = 0; i < 5000; i++) {
+        input.push_back(static_cast<std::byte>(i % 7 == 0 ? i * 31 : i % 3));
+    }
+    std::vector<std::byte> compressed = lz_compress(input);
+    std::optional<std::vector<std::byte>> decompressed = lz_decompress(compressed.data(), compressed.size(),
+                                                                       input.size());
+    check(decompressed && *decompressed == input, "LZ round trips");
+    check(compressed.size() < input.size(), "Repetitive input is compressed");
+
+    // one literal, then a match of LZ_MIN_MATCH bytes that overlaps its own output
+    std::vector<std::byte> overlapping = bytes({ 1 << 4, 'a', 1, 0, 0 });
+    std::optional<std::vector<std::byte>> repeated = lz_decompress(overlapping.data(), overlapping.size(), 5);
+    check(repeated && *repeated == bytes({ 'a', 'a', 'a', 'a', 'a' }), "Matches may overlap their output");
+
+    std::vector<std::byte> offset_past_output = bytes({ 1 << 4, 'a', 2, 0, 0 });
+    check(!lz_decompress(offset_past_output.data(), offset_past_output.size(), 5).has_value(),
+          "Match offsets before the start of the output are rejected");
+    std::vector<std::byte> zero_offset = bytes({ 1 << 4, 'a', 0, 0, 0 });
+    check(!lz_decompress(zero_offset.data(), zero_offset.size(), 5).has_value(), "Zero match offsets are rejected");
+
+    check(!lz_decompress(overlapping.data(), overlapping.size(), 4).has_value(),
+          "Output longer than the raw size is rejected");
+    check(!lz_decompress(overlapping.data(), overlapping.size(), 6).has_value(),
+          "Output shorter than the raw size is rejected");
+    check(!lz_decompress(compressed.data(), compressed.size() - 1, input.size()).has_value(),
+          "Truncated LZ data is rejected");
+}
+
+static Packet resized(Packet packet, size_t size) {
+    packet.payload.resize(size);
+    packet.header.length = static_cast<uint32_t>(size);
+    return packet;
+}
+
+static void test_packets() {
+    ChunkData chunk_data{ { -5, 3 }, 2345, generated_blocks({ -5, 3 }) };
+    Packet packet = chunk_data.serialize();
+
+    std::optional<ChunkData> decoded = ChunkData::deserialize(packet);
+    check(decoded && decoded->chunk_coords == chunk_data.chunk_coords && decoded->seed == chunk_data.seed &&
+              same_types(decoded->blocks, chunk_data.blocks),
+          "Chunk data round trips");
+
+    check(!ChunkData::deserialize(resized(packet, 11)).has_value() &&
+              !ChunkData::read_chunk_coords(resized(packet, 11)).has_value(),
+          "Chunk data shorter than its header is dropped");
+
+    Packet truncated = resized(packet, packet.payload.size() - 1);
+    check(!ChunkData::deserialize(truncated).has_value(), "Chunk data with corrupt blocks is dropped");
+    std::optional<glm::ivec2> coords = ChunkData::read_chunk_coords(truncated);
+    check(coords && *coords == chunk_data.chunk_coords, "Corrupt chunk data still names its chunk");
+
+    ChunkRequest request{ { 12, -40 }, 2345 };
+    Packet request_packet = request.serialize();
+    std::optional<ChunkRequest> decoded_request = ChunkRequest::deserialize(request_packet);
+    check(decoded_request && decoded_request->chunk_coords == request.chunk_coords &&
+              decoded_request->seed == request.seed,
+          "Chunk requests round trip");
+    check(!ChunkRequest::deserialize(resized(request_packet, 11)).has_value(), "Truncated chunk requests are dropped");
+    check(!ChunkRequest::deserialize(resized(request_packet, 13)).has_value(),
+          "Chunk requests with trailing bytes are dropped");
+}
+
+int main() {
+    test_round_trip();
+    test_malformed_chunks();
+    test_malformed_compressed_chunks();
+    test_lz();
+    test_packets();
+    return check_result();
+}
@@ -0,0 +1,104 @@
+#include "blocks/chunk_store.hpp"
+#include "check.hpp"
+
+#include <vector>
+
+constexpr int SEED = 2345;
+
+// Uniform air chunks with packets of the same size, so that every entry uses the same memory
+static void insert(ChunkStore& store, glm::ivec2 chunk_coords) {
+    std::vector<std::byte> payload(100, std::byte{ 1 });
+    store.insert(Chunk(chunk_coords, SEED), Packet::make(PacketType::ChunkData, std::move(payload)));
+}
+
+static size_t entry_memory_usage() {
+    ChunkStore store;
+    insert(store, { 0, 0 });
+    return store.get_memory_usage();
+}
+
+static bool contains(const ChunkStore& store, glm::ivec2 chunk_coords) {
+    return store.find_chunk(chunk_coords, SEED) != nullptr;
+}
+
+static void test_least_recently_used_are_evicted() {
+    size_t entry_usage = entry_memory_usage();
+    ChunkStore store(3 * entry_usage);
+
+    insert(store, { 0, 0 });
+    insert(store, { 1, 0 });
+    insert(store, { 2, 0 });
+    check(store.size() == 3 && store.get_memory_usage() == 3 * entry_usage, "Entries within the budget are kept");
+
+    insert(store, { 3, 0 });
+    check(store.size() == 3 && !contains(store, { 0, 0 }), "The oldest entry is evicted first");
+
+    // a request makes (1, 0) the most recent, so (2, 0) is the oldest
+    check(store.find_packet({ 1, 0 }, SEED).has_value(), "Stored packets are found");
+    insert(store, { 4, 0 });
+    check(contains(store, { 1, 0 }) && contains(store, { 3, 0 }) && contains(store, { 4, 0 }) &&
+              !contains(store, { 2, 0 }),
+          "A requested entry is kept over older ones");
+
+    // looking at a chunk does not count as a request
+    store.find_chunk({ 3, 0 }, SEED);
+    insert(store, { 5, 0 });
+    check(!contains(store, { 3, 0 }) && contains(store, { 1, 0 }), "find_chunk does not promote entries");
+    check(store.get_memory_usage() == 3 * entry_usage, "Evicted entries are no longer counted");
+}
+
+static void test_newest_entry_is_kept() {
+    ChunkStore store(entry_memory_usage() / 2);
+
+    insert(store, { 0, 0 });
+    check(store.size() == 1, "An entry over the budget is still stored");
+    insert(store, { 1, 0 });
+    check(store.size() == 1 && contains(store, { 1, 0 }) && !contains(store, { 0, 0 }),
+          "Only the newest entry is kept when each is over the budget");
+}
+
+static void test_replacing_an_entry() {
+    size_t entry_usage = entry_memory_usage();
+    ChunkStore store(3 * entry_usage);
+
+    insert(store, { 0, 0 });
+    insert(store, { 1, 0 });
+    insert(store, { 0, 0 });
+    check(store.size() == 2 && store.get_memory_usage() == 2 * entry_usage,
+          "Inserting a stored key replaces it without counting it twice");
+    check(store.get_stats().evictions == 0, "Replacing an entry is not an eviction");
+
+    // the replaced entry is the most recent, so (1, 0) goes first
+    insert(store, { 2, 0 });
+    insert(store, { 3, 0 });
+    check(contains(store, { 0, 0 }) && !contains(store, { 1, 0 }), "A replaced entry becomes the most recent");
+
+    check(!contains(store, { 0, 1 }) && store.find_chunk({ 0, 0 }, SEED + 1) == nullptr,
+          "Entries are keyed by coordinates and seed");
+}
+
+static void test_stats() {
+    ChunkStore store(2 * entry_memory_usage());
+
+    check(!store.find_packet({ 0, 0 }, SEED).has_value(), "Missing chunks are not found");
+    insert(store, { 0, 0 });
+    insert(store, { 1, 0 });
+    store.find_packet({ 0, 0 }, SEED);
+    store.find_packet({ 0, 0 }, SEED);
+    store.find_packet({ 1, 0 }, SEED + 1);
+    insert(store, { 2, 0 });
+    insert(store, { 3, 0 });
+
+    const ChunkStoreStats& stats = store.get_stats();
+    check(stats.hits == 2, "Every request answered from the store is a hit");
+    check(stats.misses == 2, "Every request for a missing chunk is a miss");
+    check(stats.evictions == 2, "Every evicted entry is counted");
+}
+
+int main() {
+    test_least_recently_used_are_evicted();
+    test_newest_entry_is_kept();
+    test_replacing_an_entry();
+    test_stats();
+    return check_result();
+}
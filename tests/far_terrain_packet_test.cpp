@@ -0,0 +1,59 @@
+#include "blocks/far_terrain.hpp"
+#include "check.hpp"
+
+#include <optional>
+
+static FarTerrainData make_tile() {
+    FarTerrainData tile{};
+    tile.tile_coords = { -3, 7 };
+    tile.seed = 2345;
+    tile.heights.resize(SAMPLES_PER_FAR_TILE);
+    tile.top_blocks.resize(SAMPLES_PER_FAR_TILE);
+    for (int i = 0; i < SAMPLES_PER_FAR_TILE; i++) {
+        tile.heights[i] = static_cast<uint8_t>(i * 7);
+        tile.top_blocks[i] = static_cast<uint8_t>(i % Block::Type::SIZE);
+    }
+    return tile;
+}
+
+static Packet resized(Packet packet, size_t size) {
+    packet.payload.resize(size);
+    packet.header.length = static_cast<uint32_t>(size);
+    return packet;
+}
+
+static void test_request() {
+    FarTerrainRequest request{ { 12, -40 }, 2345 };
+    Packet packet = request.serialize();
+
+    std::optional<FarTerrainRequest> decoded = FarTerrainRequest::deserialize(packet);
+    check(decoded && decoded->tile_coords == request.tile_coords && decoded->seed == request.seed,
+          "Requests round trip");
+
+    check(!FarTerrainRequest::deserialize(resized(packet, 0)).has_value(), "Empty requests are dropped");
+    check(!FarTerrainRequest::deserialize(resized(packet, packet.payload.size() - 1)).has_value(),
+          "Truncated requests are dropped");
+    check(!FarTerrainRequest::deserialize(resized(packet, packet.payload.size() + 1)).has_value(),
+          "Requests with trailing bytes are dropped");
+}
+
+static void test_data() {
+    FarTerrainData tile = make_tile();
+    Packet packet = tile.serialize();
+
+    std::optional<FarTerrainData> decoded = FarTerrainData::deserialize(packet);
+    check(decoded && decoded->tile_coords == tile.tile_coords && decoded->seed == tile.seed &&
+          decoded->heights == tile.heights && decoded->top_blocks == tile.top_blocks, "Tiles round trip");
+
+    check(!FarTerrainData::deserialize(resized(packet, 12)).has_value(), "Tiles without samples are dropped");
+    check(!FarTerrainData::deserialize(resized(packet, packet.payload.size() - 1)).has_value(),
+          "Truncated tiles are dropped");
+    check(!FarTerrainData::deserialize(resized(packet, packet.payload.size() + 1)).has_value(),
+          "Tiles with trailing bytes are dropped");
+}
+
+int main() {
+    test_request();
+    test_data();
+    return check_result();
+}
@@ -0,0 +1,86 @@
+#include "graphics/frustum.hpp"
+#include "check.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+// The batch test computes the positive corner distance from the box center and extents, intersects_aabb from the
+// corner itself, so the two may round differently for a box touching a plane. A disagreement only counts if the box
+// is clearly on one side: shrinking and growing it by a small margin gives the same answer.
+static bool borderline(const Frustum& frustum, const AABB& box) {
+    const glm::vec3 margin(0.01f);
+    return frustum.intersects_aabb(box.min - margin, box.max + margin) !=
+           frustum.intersects_aabb(box.min + margin, box.max - margin);
+}
+
+static void test_default_frustum() {
+    Frustum frustum;
+    AABBBatch boxes;
+    boxes.add({ glm::vec3(-1e6f), glm::vec3(-1e6f + 1.0f) });
+    boxes.add({ glm::vec3(0.0f), glm::vec3(16.0f, 16.0f, 256.0f) });
+
+    std::vector<uint32_t> visible;
+    check(frustum.cull(boxes, visible) == 2, "A default frustum contains everything");
+    check(visible.size() == 2, "The results are trimmed to the boxes, without the padding");
+}
+
+// random cameras and chunk sized boxes around them, culled as a batch and one box at a time
+static void test_batch_matches_single_boxes() {
+    std::mt19937 rng(2345);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    size_t n_boxes_tested = 0;
+    size_t n_visible_total = 0;
+    size_t n_borderline = 0;
+    for (int camera = 0; camera < 50; camera++) {
+        glm::vec3 eye(unit(rng) * 256.0f - 128.0f, unit(rng) * 256.0f - 128.0f, 20.0f + unit(rng) * 200.0f);
+        glm::vec3 target = eye + glm::vec3(unit(rng) - 0.5f, unit(rng) - 0.5f, unit(rng) - 0.5f) * 10.0f;
+        glm::mat4 view = glm::lookAt(eye, target, glm::vec3(0.0f, 0.0f, 1.0f));
+        glm::mat4 projection = glm::perspective(glm::radians(45.0f + unit(rng) * 45.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+        Frustum frustum(projection * view);
+
+        // a count that is not a multiple of AABBBatch::LANES, so the last block has padding
+        std::vector<AABB> boxes;
+        AABBBatch batch;
+        for (int i = 0; i < 1000 + camera; i++) {
+            glm::vec3 min(std::floor(unit(rng) * 40.0f - 20.0f) * 16.0f, std::floor(unit(rng) * 40.0f - 20.0f) * 16.0f,
+                          0.0f);
+            glm::vec3 max = min + glm::vec3(16.0f, 16.0f, 16.0f + std::floor(unit(rng) * 15.0f) * 16.0f);
+            boxes.push_back({ min, max });
+            batch.add(boxes.back());
+        }
+
+        std::vector<uint32_t> visible;
+        size_t n_visible = frustum.cull(batch, visible);
+        check(visible.size() == boxes.size(), "One result per box");
+
+        size_t n_counted = 0;
+        for (size_t i = 0; i < boxes.size(); i++) {
+            n_counted += visible[i];
+            bool expected = frustum.intersects_aabb(boxes[i].min, boxes[i].max);
+            if (static_cast<bool>(visible[i]) != expected) {
+                if (!borderline(frustum, boxes[i])) {
+                    check(false, "Batch culling disagrees with intersects_aabb for box " + std::to_string(i) +
+                                     " of camera " + std::to_string(camera));
+                    return;
+                }
+                n_borderline++;
+            }
+        }
+        check(n_visible == n_counted, "cull returns the number of visible boxes");
+
+        n_boxes_tested += boxes.size();
+        n_visible_total += n_visible;
+    }
+
+    // the cameras must actually see part of the boxes for the comparison to mean anything
+    check(n_visible_total > 0 && n_visible_total < n_boxes_tested, "Some boxes are visible and some are culled");
+    check(n_borderline * 1000 < n_boxes_tested, "Disagreements on boxes touching a plane are rare");
+}
+
+int main() {
+    test_default_frustum();
+    test_batch_matches_single_boxes();
+    return check_result();
+}
@@ -0,0 +1,86 @@
+#include "blocks/chunk.hpp"
+#include "blocks/padded_chunk.hpp"
+#include "check.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+// A generated chunk at the origin with its 8 neighbors
+struct TestWorld {
+    std::vector<Chunk> chunks{};
+    std::unordered_map<glm::ivec2, size_t> chunk_index_map{};
+
+    TestWorld() {
+        for (int x = -1; x <= 1; x++) {
+            for (int y = -1; y <= 1; y++) {
+                Chunk chunk({ x, y }, 2345);
+                chunk.generate_blocks_from_seed();
+                chunk_index_map[{ x, y }] = chunks.size();
+                chunks.push_back(std::move(chunk));
+            }
+        }
+    }
+
+    Chunk& at(glm::ivec2 chunk_coords) {
+        return chunks[chunk_index_map.at(chunk_coords)];
+    }
+
+    PaddedChunk pad(glm::ivec2 chunk_coords) {
+        return PaddedChunk(at(chunk_coords), chunks, chunk_index_map);
+    }
+
+    void set_lod(int lod) {
+        for (Chunk& chunk : chunks) {
+            chunk.set_lod(lod);
+        }
+    }
+};
+
+// The left border of the center chunk holds the blocks of its left neighbor as that neighbor is meshed
+static bool left_border_matches_neighbor(TestWorld& world) {
+    PaddedChunk center = world.pad({ 0, 0 });
+    PaddedChunk left = world.pad({ -1, 0 });
+    for (int z = 0; z < CHUNK_HEIGHT; z++) {
+        for (int y = 0; y < CHUNK_WIDTH; y++) {
+            if (center.get_block({ -1, y, z }).type != left.get_block({ CHUNK_LENGTH - 1, y, z }).type) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool left_border_is_air(TestWorld& world) {
+    PaddedChunk center = world.pad({ 0, 0 });
+    for (int z = 0; z < CHUNK_HEIGHT; z++) {
+        for (int y = 0; y < CHUNK_WIDTH; y++) {
+            if (center.get_block({ -1, y, z }).type != Block::Type::AIR) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void test_borders() {
+    TestWorld world;
+    check(left_border_matches_neighbor(world), "Full detail chunks copy the border of full detail neighbors");
+
+    world.set_lod(1);
+    check(left_border_matches_neighbor(world), "Downsampled chunks copy the downsampled border of neighbors at their level");
+    world.set_lod(2);
+    check(left_border_matches_neighbor(world), "The border is downsampled at the level of the neighbor");
+
+    world.set_lod(0);
+    world.at({ -1, 0 }).set_lod(2);
+    check(left_border_matches_neighbor(world), "The border facing a coarser neighbor holds its downsampled blocks");
+
+    world.set_lod(1);
+    world.at({ -1, 0 }).set_lod(0);
+    check(left_border_is_air(world), "The border facing a finer neighbor is air, so a skirt is meshed along it");
+}
+
+int main() {
+    test_borders();
+    return check_result();
+}
@@ -0,0 +1,97 @@
+#include "blocks/palette_storage.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static bool matches(const PaletteStorage& storage, const std::vector<Block::Type>& reference) {
+    for (size_t i = 0; i < reference.size(); i++) {
+        if (storage.get(i).type != reference[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_widening() {
+    PaletteStorage storage(4096);
+    check(storage.get_bits_per_index() == 0 && storage.memory_usage() < 64, "Uniform storage needs no indices");
+
+    storage.set(10, { Block::Type::STONE });
+    check(storage.get_bits_per_index() == 1, "A second type needs 1 bit");
+    storage.set(11, { Block::Type::DIRT });
+    check(storage.get_bits_per_index() == 2, "A third type needs 2 bits");
+    storage.set(12, { Block::Type::GRASS });
+    check(storage.get_bits_per_index() == 2, "A fourth type still fits 2 bits");
+    storage.set(13, { Block::Type::WATER });
+    check(storage.get_bits_per_index() == 4, "A fifth type needs 4 bits");
+
+    check(storage.get(9).type == Block::Type::AIR && storage.get(10).type == Block::Type::STONE &&
+          storage.get(13).type == Block::Type::WATER, "Widening keeps the blocks");
+}
+
+static void test_compaction() {
+    PaletteStorage storage(4096);
+    std::vector<Block::Type> reference(4096, Block::Type::AIR);
+    auto set = [&](size_t index, Block::Type type) {
+        storage.set(index, { type });
+        reference[index] = type;
+    };
+
+    // air, stone, dirt and grass fill the 2 bit palette
+    for (size_t i = 0; i < 4096; i++) {
+        set(i, i < 1024 ? Block::Type::STONE : i < 2048 ? Block::Type::DIRT : i < 3072 ? Block::Type::GRASS : Block::Type::AIR);
+    }
+    check(storage.get_bits_per_index() == 2 && storage.get_palette().size() == 4, "Four types fill 2 bits");
+
+    // dig out all the stone, then place glass: it takes the slot of stone instead of widening
+    for (size_t i = 0; i < 1024; i++) {
+        set(i, Block::Type::AIR);
+    }
+    set(5, Block::Type::GLASS);
+    check(storage.get_bits_per_index() == 2, "A type replacing an unused one does not widen the indices");
+    check(storage.get_palette().size() == 4, "The unused type is dropped from the palette");
+    check(matches(storage, reference), "Compaction keeps the blocks");
+
+    // with every entry in use, a new type still widens
+    set(6, Block::Type::WATER);
+    check(storage.get_bits_per_index() == 4, "A full palette with no unused types widens");
+    check(matches(storage, reference), "Widening after compaction keeps the blocks");
+}
+
+// random writes of a few types at a time, checked against a plain array
+static void test_random_writes() {
+    std::mt19937 rng(2345);
+    PaletteStorage storage(4096);
+    std::vector<Block::Type> reference(4096, Block::Type::AIR);
+
+    for (int round = 0; round < 200; round++) {
+        // each round writes a random region with a random subset of the types
+        std::vector<Block::Type> types;
+        for (int i = 0; i < 1 + static_cast<int>(rng() % 3); i++) {
+            types.push_back(static_cast<Block::Type>(rng() % Block::Type::SIZE));
+        }
+        size_t begin = rng() % 4096;
+        size_t end = std::min<size_t>(4096, begin + rng() % 2048);
+        for (size_t i = begin; i < end; i++) {
+            Block::Type type = types[rng() % types.size()];
+            storage.set(i, { type });
+            reference[i] = type;
+        }
+
+        if (!matches(storage, reference)) {
+            check(false, "Random writes do not match the reference array");
+            return;
+        }
+        check((size_t{1} << storage.get_bits_per_index()) >= storage.get_palette().size(),
+              "Every palette entry is addressable");
+    }
+}
+
+int main() {
+    test_widening();
+    test_compaction();
+    test_random_writes();
+    return check_result();
+}
@@ -0,0 +1,113 @@
+#include "blocks/chunk_mesher.hpp"
+#include "blocks/quad_record.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+// Expands quad records into triangles the way voxel.vert and the shared index buffer do, and compares them with the
+// six vertex triangle lists chunks were meshed into before quads were indexed.
+
+using Triangle = std::array<int, 3>;
+
+// same tables as voxel.vert
+const float ao_values[4] = { 0.512f, 0.64f, 0.8f, 1.0f };
+
+const glm::ivec3 face_corners[6][4] = {
+    { { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } }, // TOP
+    { { 0, 1, 0 }, { 1, 1, 0 }, { 1, 0, 0 }, { 0, 0, 0 } }, // BOTTOM
+    { { 0, 1, 0 }, { 0, 0, 0 }, { 0, 0, 1 }, { 0, 1, 1 } }, // LEFT
+    { { 1, 0, 0 }, { 1, 1, 0 }, { 1, 1, 1 }, { 1, 0, 1 } }, // RIGHT
+    { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 }, { 0, 0, 1 } }, // FRONT
+    { { 1, 1, 0 }, { 0, 1, 0 }, { 0, 1, 1 }, { 1, 1, 1 } }, // BACK
+};
+
+const glm::ivec2 face_plane_axes[6] = { { 0, 1 }, { 0, 1 }, { 1, 2 }, { 1, 2 }, { 0, 2 }, { 0, 2 } };
+
+const glm::ivec3 face_normals[6] = { { 0, 0, 1 }, { 0, 0, -1 }, { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 } };
+
+// corner drawn by each vertex of the quad, as voxel.vert picks it from gl_VertexID
+static int vertex_corner(const QuadRecord& record, int vertex) {
+    const glm::ivec4& ao = record.ao_state;
+    int first_corner = ao_values[ao[0]] + ao_values[ao[2]] > ao_values[ao[1]] + ao_values[ao[3]] ? 0 : 1;
+    return (first_corner + vertex) % 4;
+}
+
+static glm::ivec3 corner_position(const QuadRecord& record, int corner) {
+    glm::ivec3 offset = face_corners[record.face][corner];
+    glm::ivec2 axes = face_plane_axes[record.face];
+    offset[axes.x] *= record.size.x;
+    offset[axes.y] *= record.size.y;
+    return record.chunk_pos + offset;
+}
+
+// rotated to start at the smallest corner, which keeps the winding, then sorted
+static std::vector<Triangle> normalize(std::vector<Triangle> triangles) {
+    for (Triangle& triangle : triangles) {
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+// triangles of corners from the indexed draw
+static std::vector<Triangle> indexed_triangles(const QuadRecord& record) {
+    std::vector<Triangle> triangles;
+    for (int i = 0; i < INDICES_PER_QUAD; i += 3) {
+        triangles.push_back({ vertex_corner(record, QUAD_INDICES[i]),
+                              vertex_corner(record, QUAD_INDICES[i + 1]),
+                              vertex_corner(record, QUAD_INDICES[i + 2]) });
+    }
+    return normalize(triangles);
+}
+
+// triangles of corners chunks used to emit as six vertices: split along corners 0-2 unless that diagonal is darker
+static std::vector<Triangle> six_vertex_triangles(const QuadRecord& record) {
+    const glm::ivec4& ao = record.ao_state;
+    if (ao_values[ao[0]] + ao_values[ao[2]] > ao_values[ao[1]] + ao_values[ao[3]]) {
+        return normalize({ { 0, 1, 2 }, { 2, 3, 0 } });
+    }
+    return normalize({ { 0, 1, 3 }, { 1, 2, 3 } });
+}
+
+static void test_every_face_and_ao_state() {
+    const std::array<glm::ivec2, 3> sizes = { glm::ivec2(1, 1), glm::ivec2(3, 1), glm::ivec2(16, 256) };
+    for (int face = 0; face < 6; face++) {
+        for (int ao_bits = 0; ao_bits < 256; ao_bits++) {
+            for (glm::ivec2 size : sizes) {
+                QuadRecord record{};
+                record.chunk_pos = { 2, 5, 70 };
+                record.face = face;
+                record.ao_state = { ao_bits & 3, (ao_bits >> 2) & 3, (ao_bits >> 4) & 3, (ao_bits >> 6) & 3 };
+                record.size = size;
+                record = QuadRecord::unpack(record.pack());
+
+                std::vector<Triangle> triangles = indexed_triangles(record);
+                if (triangles != six_vertex_triangles(record)) {
+                    check(false, "Indexed quad does not split like the six vertex triangles, face " +
+                                     std::to_string(face) + " ao " + std::to_string(ao_bits));
+                    return;
+                }
+
+                // counter-clockwise seen from outside the block, and together covering the whole quad
+                int area = 0;
+                for (const Triangle& triangle : triangles) {
+                    glm::ivec3 a = corner_position(record, triangle[0]);
+                    glm::ivec3 b = corner_position(record, triangle[1]);
+                    glm::ivec3 c = corner_position(record, triangle[2]);
+                    glm::ivec3 normal = glm::cross(b - a, c - a);
+                    int twice_area = glm::dot(normal, face_normals[face]);
+                    check(twice_area > 0, "Triangles face out of the block, face " + std::to_string(face));
+                    area += twice_area;
+                }
+                check(area == 2 * size.x * size.y, "The two triangles cover the quad");
+            }
+        }
+    }
+}
+
+int main() {
+    test_every_face_and_ao_state();
+    return check_result();
+}
@@ -0,0 +1,88 @@
+#include "blocks/quad_record.hpp"
+#include "check.hpp"
+
+#include <array>
+#include <random>
+
+static bool round_trips(const QuadRecord& record) {
+    return QuadRecord::unpack(record.pack()) == record;
+}
+
+// every field at both ends of its range, with the other fields at theirs, so a field spilling into a neighbor shows
+static void test_field_edges() {
+    const std::array<int, 2> x_values = { 0, 15 };
+    const std::array<int, 2> z_values = { 0, 255 };
+    const std::array<int, 2> face_values = { 0, 5 };
+    const std::array<int, 2> texture_values = { 0, 127 };
+    const std::array<int, 2> ao_values = { 0, 3 };
+    const std::array<int, 2> size_values = { 1, 256 };
+
+    int n_records = 0;
+    for (int x : x_values)
+    for (int y : x_values)
+    for (int z : z_values)
+    for (int face : face_values)
+    for (int texture_index : texture_values)
+    for (int ao_bits = 0; ao_bits < 16; ao_bits++)
+    for (int size_x : size_values)
+    for (int size_y : size_values) {
+        QuadRecord record{};
+        record.chunk_pos = { x, y, z };
+        record.face = face;
+        record.texture_index = texture_index;
+        for (int i = 0; i < 4; i++) {
+            record.ao_state[i] = ao_values[(ao_bits >> i) & 1];
+        }
+        record.size = { size_x, size_y };
+
+        if (!round_trips(record)) {
+            check(false, "Quad record does not round trip at x " + std::to_string(x) + " y " + std::to_string(y) +
+                             " z " + std::to_string(z) + " face " + std::to_string(face) + " texture " +
+                             std::to_string(texture_index) + " size " + std::to_string(size_x) + "x" +
+                             std::to_string(size_y));
+            return;
+        }
+        n_records++;
+    }
+    check(n_records == 2 * 2 * 2 * 2 * 2 * 16 * 2 * 2, "Every combination of edges is tried");
+}
+
+// the layout documented in quad_record.hpp, which voxel.vert decodes
+static void test_layout() {
+    QuadRecord record{};
+    record.chunk_pos = { 15, 0, 255 };
+    record.face = 5;
+    record.texture_index = 127;
+    record.ao_state = { 3, 0, 2, 1 };
+    record.size = { 256, 1 };
+
+    std::array<uint32_t, QUAD_RECORD_WORDS> words = record.pack();
+    check(words[0] == (15u | 0u << 4 | 255u << 8 | 5u << 16 | 127u << 19), "Word 0 follows the documented layout");
+    check(words[1] == (3u | 0u << 2 | 2u << 4 | 1u << 6 | 255u << 8 | 0u << 16), "Word 1 follows the documented layout");
+    check(words[0] >> 26 == 0 && words[1] >> 24 == 0, "Unused high bits stay clear");
+}
+
+static void test_random() {
+    std::mt19937 rng(2345);
+    for (int i = 0; i < 100000; i++) {
+        QuadRecord record{};
+        record.chunk_pos = { static_cast<int>(rng() % 16), static_cast<int>(rng() % 16), static_cast<int>(rng() % 256) };
+        record.face = static_cast<int>(rng() % 6);
+        record.texture_index = static_cast<int>(rng() % 128);
+        record.ao_state = { static_cast<int>(rng() % 4), static_cast<int>(rng() % 4), static_cast<int>(rng() % 4),
+                            static_cast<int>(rng() % 4) };
+        record.size = { 1 + static_cast<int>(rng() % 256), 1 + static_cast<int>(rng() % 256) };
+
+        if (!round_trips(record)) {
+            check(false, "Random quad record does not round trip");
+            return;
+        }
+    }
+}
+
+int main() {
+    test_field_edges();
+    test_layout();
+    test_random();
+    return check_result();
+}
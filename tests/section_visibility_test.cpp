@@ -0,0 +1,212 @@
+#include "blocks/chunk.hpp"
+#include "blocks/chunk_mesher.hpp"
+#include "blocks/padded_chunk.hpp"
+#include "blocks/quad_record.hpp"
+#include "blocks/section_visibility.hpp"
+#include "check.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+constexpr int TEST_SECTION = 3;
+
+static SectionVisibility compute_visibility(const Chunk& chunk) {
+    std::vector<Chunk> no_neighbors;
+    std::unordered_map<glm::ivec2, size_t> no_index_map;
+    return SectionVisibility::compute(PaddedChunk(chunk, no_neighbors, no_index_map), TEST_SECTION);
+}
+
+static void fill_section(Chunk& chunk, Block::Type type) {
+    for (int z = 0; z < SECTION_HEIGHT; z++) {
+        for (int y = 0; y < CHUNK_WIDTH; y++) {
+            for (int x = 0; x < CHUNK_LENGTH; x++) {
+                chunk.set_block({ x, y, TEST_SECTION * SECTION_HEIGHT + z }, { type });
+            }
+        }
+    }
+}
+
+static int count_connections(const SectionVisibility& visibility) {
+    int n_connections = 0;
+    for (int face_a = 0; face_a < 6; face_a++) {
+        for (int face_b = 0; face_b < 6; face_b++) {
+            n_connections += visibility.are_connected(face_a, face_b);
+        }
+    }
+    return n_connections;
+}
+
+static void test_empty_section() {
+    Chunk chunk({ 0, 0 }, 2345);
+    check(count_connections(compute_visibility(chunk)) == 36, "An empty section connects every face");
+}
+
+static void test_solid_section() {
+    Chunk chunk({ 0, 0 }, 2345);
+    fill_section(chunk, Block::Type::STONE);
+    check(count_connections(compute_visibility(chunk)) == 0, "A solid section connects no faces");
+
+    // a closed cave inside touches no face either
+    for (int z = 4; z < 10; z++) {
+        for (int y = 4; y < 10; y++) {
+            for (int x = 4; x < 10; x++) {
+                chunk.set_block({ x, y, TEST_SECTION * SECTION_HEIGHT + z }, { Block::Type::AIR });
+            }
+        }
+    }
+    check(count_connections(compute_visibility(chunk)) == 0, "A closed cave connects no faces");
+
+    fill_section(chunk, Block::Type::GLASS);
+    check(count_connections(compute_visibility(chunk)) == 36, "Glass is seen through");
+}
+
+static void test_tunnel() {
+    Chunk chunk({ 0, 0 }, 2345);
+    fill_section(chunk, Block::Type::STONE);
+    for (int x = 0; x < CHUNK_LENGTH; x++) {
+        chunk.set_block({ x, 5, TEST_SECTION * SECTION_HEIGHT + 7 }, { Block::Type::AIR });
+    }
+
+    SectionVisibility visibility = compute_visibility(chunk);
+    check(visibility.are_connected(VoxelQuad::LEFT, VoxelQuad::RIGHT) &&
+          visibility.are_connected(VoxelQuad::RIGHT, VoxelQuad::LEFT), "A tunnel connects the faces at its ends");
+    check(visibility.are_connected(VoxelQuad::LEFT, VoxelQuad::LEFT), "A face touched by a tunnel sees itself");
+    check(count_connections(visibility) == 4, "A tunnel connects only the faces at its ends");
+
+    // blocks that only touch diagonally do not connect
+    Chunk shaft({ 0, 0 }, 2345);
+    fill_section(shaft, Block::Type::STONE);
+    for (int z = 0; z < 8; z++) {
+        shaft.set_block({ 3, 3, TEST_SECTION * SECTION_HEIGHT + z }, { Block::Type::AIR });
+    }
+    for (int z = 8; z < SECTION_HEIGHT; z++) {
+        shaft.set_block({ 4, 4, TEST_SECTION * SECTION_HEIGHT + z }, { Block::Type::AIR });
+    }
+    check(!compute_visibility(shaft).are_connected(VoxelQuad::TOP, VoxelQuad::BOTTOM),
+          "Shafts that only touch diagonally are not connected");
+    shaft.set_block({ 4, 3, TEST_SECTION * SECTION_HEIGHT + 7 }, { Block::Type::AIR });
+    shaft.set_block({ 4, 4, TEST_SECTION * SECTION_HEIGHT + 7 }, { Block::Type::AIR });
+    check(compute_visibility(shaft).are_connected(VoxelQuad::TOP, VoxelQuad::BOTTOM),
+          "Opening a path between the shafts connects them");
+}
+
+// A row of four chunks with the camera in the first one, looking along x through a default frustum. All sections
+// connect every face, except for the sections of the wall chunk
+static std::vector<uint16_t> find_sections_behind_wall(const SectionVisibility& wall_visibility) {
+    std::vector<Chunk> chunks;
+    std::unordered_map<glm::ivec2, size_t> chunk_index_map;
+    for (int x = 0; x < 4; x++) {
+        Chunk chunk({ x, 0 }, 2345);
+        if (x == 2) {
+            ChunkVisibility visibility;
+            visibility.fill(wall_visibility);
+            chunk.set_section_visibility(visibility);
+        }
+        chunk_index_map[{ x, 0 }] = chunks.size();
+        chunks.push_back(std::move(chunk));
+    }
+
+    std::vector<uint16_t> visible_sections;
+    find_visible_sections(glm::vec3(8.0f, 8.0f, 8.5f * SECTION_HEIGHT), Frustum(), chunks, chunk_index_map,
+                          visible_sections);
+    return visible_sections;
+}
+
+static void test_search_stops_at_wall() {
+    std::vector<uint16_t> open = find_sections_behind_wall(SectionVisibility::all_connected());
+    check(open.size() == 4, "One mask per loaded chunk");
+    check(open[0] == UINT16_MAX && open[1] == UINT16_MAX && open[2] == UINT16_MAX && open[3] == UINT16_MAX,
+          "Every section is reached without a wall");
+
+    std::vector<uint16_t> sealed = find_sections_behind_wall(SectionVisibility{});
+    check(sealed[0] == UINT16_MAX && sealed[1] == UINT16_MAX, "Sections in front of the wall are reached");
+    check(sealed[2] == UINT16_MAX, "The wall itself is reached");
+    check(sealed[3] == 0, "Nothing behind the wall is reached");
+
+    // a wall that only connects the face looking at the camera to itself still hides what is behind it
+    SectionVisibility cave;
+    cave.connect(VoxelQuad::LEFT, VoxelQuad::LEFT);
+    check(find_sections_behind_wall(cave)[3] == 0, "A cave open towards the camera hides what is behind it");
+
+    SectionVisibility tunnel;
+    tunnel.connect(VoxelQuad::LEFT, VoxelQuad::RIGHT);
+    check(find_sections_behind_wall(tunnel)[3] == UINT16_MAX, "A tunnel through the wall is seen through");
+}
+
+static void test_camera_outside_loaded_chunks() {
+    std::vector<Chunk> chunks;
+    chunks.emplace_back(glm::ivec2(0, 0), 2345);
+    std::unordered_map<glm::ivec2, size_t> chunk_index_map{ { { 0, 0 }, 0 } };
+
+    std::vector<uint16_t> visible_sections;
+    find_visible_sections(glm::vec3(100.0f, 100.0f, 8.0f), Frustum(), chunks, chunk_index_map, visible_sections);
+    check(visible_sections.size() == 1 && visible_sections[0] == UINT16_MAX,
+          "Nothing is ruled out without a chunk to start from");
+}
+
+// Every quad of a mesh is in the range of the section of its block, so that drawing only some sections draws all of
+// their quads, and merged side faces stop at section borders
+static void test_section_quad_ranges() {
+    // a glass pillar and a stone wall through several sections, on a floor of stone
+    Chunk chunk({ 0, 0 }, 2345);
+    for (int y = 0; y < CHUNK_WIDTH; y++) {
+        for (int x = 0; x < CHUNK_LENGTH; x++) {
+            chunk.set_block({ x, y, 0 }, { Block::Type::STONE });
+        }
+    }
+    for (int z = 1; z < 90; z++) {
+        chunk.set_block({ 3, 3, z }, { Block::Type::GLASS });
+        for (int x = 8; x < 12; x++) {
+            chunk.set_block({ x, 10, z }, { Block::Type::STONE });
+        }
+    }
+
+    std::vector<Chunk> no_neighbors;
+    std::unordered_map<glm::ivec2, size_t> no_index_map;
+    PaddedChunk padded_chunk(chunk, no_neighbors, no_index_map);
+    TextureManager texture_manager;
+    ChunkMesher mesher;
+
+    for (MeshingMode mode : { MeshingMode::PerFace, MeshingMode::Greedy, MeshingMode::Binary }) {
+        ChunkMeshData mesh = mesher.mesh(padded_chunk, texture_manager, mode);
+        size_t n_quads = mesh.quad_data.size() / QUAD_RECORD_WORDS;
+        check(mesh.opaque_sections[0] == 0 && mesh.translucent_sections[0] == 0, "Section offsets start at 0");
+        check(mesh.opaque_sections[SECTIONS_PER_CHUNK] == mesh.n_opaque_quads &&
+                  mesh.n_opaque_quads + mesh.translucent_sections[SECTIONS_PER_CHUNK] == n_quads,
+              "Section offsets cover every quad");
+        check(mesh.translucent_sections[SECTIONS_PER_CHUNK] > 0, "The glass pillar is meshed");
+
+        bool in_section = true;
+        bool within_section = true;
+        for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+            for (int kind = 0; kind < 2; kind++) {
+                const SectionQuadOffsets& sections = kind == 0 ? mesh.opaque_sections : mesh.translucent_sections;
+                size_t first_quad = kind == 0 ? 0 : mesh.n_opaque_quads;
+                for (size_t i = sections[section_index]; i < sections[section_index + 1]; i++) {
+                    const uint32_t* words = &mesh.quad_data[(first_quad + i) * QUAD_RECORD_WORDS];
+                    QuadRecord record = QuadRecord::unpack({ words[0], words[1] });
+                    // see texture_manager_stub.cpp
+                    Block::Type block_type = static_cast<Block::Type>(record.texture_index / 6);
+                    in_section = in_section && record.chunk_pos.z / SECTION_HEIGHT == section_index &&
+                                 Block::is_transparent({ block_type }) == (kind == 1);
+
+                    bool side_face = record.face != VoxelQuad::TOP && record.face != VoxelQuad::BOTTOM;
+                    within_section = within_section && (!side_face || record.chunk_pos.z + record.size.y <=
+                                                                          (section_index + 1) * SECTION_HEIGHT);
+                }
+            }
+        }
+        check(in_section, "Quads are grouped by kind and by the section of their block");
+        check(within_section, "Merged quads do not cross sections");
+    }
+}
+
+int main() {
+    test_empty_section();
+    test_solid_section();
+    test_tunnel();
+    test_search_stops_at_wall();
+    test_camera_outside_loaded_chunks();
+    test_section_quad_ranges();
+    return check_result();
+}
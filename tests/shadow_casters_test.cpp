@@ -0,0 +1,70 @@
+#include "graphics/shadow_casters.hpp"
+#include "check.hpp"
+
+#include <vector>
+
+// Three nested cascades looking down the z axis, each twice as long along x as the one before:
+// x in [0, 32], [0, 64] and [0, 128], y in [0, 32] and z in [-256, 256]
+static std::vector<glm::mat4> nested_cascades() {
+    std::vector<glm::mat4> light_matrices;
+    for (int i = 0; i < 3; i++) {
+        light_matrices.push_back(glm::ortho(0.0f, 32.0f * (1 << i), 0.0f, 32.0f, -256.0f, 256.0f));
+    }
+    return light_matrices;
+}
+
+enum Caster : uint32_t {
+    IN_EVERY_CASCADE,
+    IN_OUTER_TWO,
+    IN_LAST_ONLY,
+    PAST_EVERY_CASCADE,
+    BESIDE_EVERY_CASCADE,
+    ACROSS_FIRST_EDGE,
+};
+
+static AABBBatch caster_boxes() {
+    AABBBatch boxes;
+    boxes.add({ { 4.0f, 4.0f, 60.0f }, { 8.0f, 8.0f, 70.0f } });
+    boxes.add({ { 40.0f, 4.0f, 60.0f }, { 44.0f, 8.0f, 70.0f } });
+    boxes.add({ { 100.0f, 4.0f, 60.0f }, { 104.0f, 8.0f, 70.0f } });
+    boxes.add({ { 500.0f, 4.0f, 60.0f }, { 504.0f, 8.0f, 70.0f } });
+    boxes.add({ { 4.0f, 100.0f, 60.0f }, { 8.0f, 104.0f, 70.0f } });
+    boxes.add({ { 30.0f, 4.0f, 60.0f }, { 34.0f, 8.0f, 70.0f } });
+    return boxes;
+}
+
+static void test_casters_outside_every_cascade_are_culled() {
+    ShadowCasterSelection selection;
+    selection.select(nested_cascades(), 0b111, caster_boxes());
+
+    check(selection.get_casters(0) == std::vector<uint32_t>{ IN_EVERY_CASCADE, ACROSS_FIRST_EDGE },
+          "The first cascade draws the casters inside or across its edge");
+    check(selection.get_casters(1) == std::vector<uint32_t>{ IN_EVERY_CASCADE, IN_OUTER_TWO, ACROSS_FIRST_EDGE },
+          "The second cascade draws the casters inside it");
+    check(selection.get_casters(2) ==
+              std::vector<uint32_t>{ IN_EVERY_CASCADE, IN_OUTER_TWO, IN_LAST_ONLY, ACROSS_FIRST_EDGE },
+          "The last cascade draws every caster inside it");
+    check(selection.total_casters() == 9, "The total counts every cascade's draws");
+}
+
+static void test_mask_limits_cascades() {
+    ShadowCasterSelection selection;
+    selection.select(nested_cascades(), 0b111, caster_boxes());
+
+    // cascades left out of the mask are emptied, not kept from the previous selection
+    selection.select(nested_cascades(), 0b010, caster_boxes());
+    check(selection.get_casters(0).empty() && selection.get_casters(2).empty(),
+          "Cascades outside the mask get no casters");
+    check(selection.get_casters(1) == std::vector<uint32_t>{ IN_EVERY_CASCADE, IN_OUTER_TWO, ACROSS_FIRST_EDGE },
+          "A cascade in the mask gets its casters");
+    check(selection.total_casters() == 3, "Only the cascades in the mask are counted");
+
+    selection.select(nested_cascades(), 0, caster_boxes());
+    check(selection.total_casters() == 0, "An empty mask selects nothing");
+}
+
+int main() {
+    test_casters_outside_every_cascade_are_culled();
+    test_mask_limits_cascades();
+    return check_result();
+}
@@ -0,0 +1,9 @@
+#include "graphics/texture_manager.hpp"
+
+// Stands in for the texture lookup of the meshers when testing without a GL context: no images are loaded, and
+// every face of every block type gets its own index
+TextureManager::TextureManager() {}
+
+int TextureManager::get_texture_index(Block::Type block_type, VoxelQuad::Face block_face) const {
+    return block_type * 6 + block_face;
+}
@@ -0,0 +1,140 @@
+#include "blocks/quad_record.hpp"
+#include "blocks/translucency_sorter.hpp"
+#include "check.hpp"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Random quads of every face and size, grouped by the section of their block like the mesher does
+static std::vector<uint32_t> random_quads(std::mt19937& rng, SectionQuadOffsets& sections) {
+    std::uniform_int_distribution<int> section_size(0, 40);
+    std::uniform_int_distribution<int> coordinate(0, 15);
+    std::uniform_int_distribution<int> face(0, 5);
+    std::uniform_int_distribution<int> size(1, 16);
+
+    std::vector<uint32_t> quad_data;
+    sections[0] = 0;
+    for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+        int n_quads = section_size(rng);
+        for (int i = 0; i < n_quads; i++) {
+            QuadRecord record{};
+            record.chunk_pos = { coordinate(rng), coordinate(rng), section_index * SECTION_HEIGHT + coordinate(rng) };
+            record.face = face(rng);
+            record.texture_index = static_cast<int>(quad_data.size() / QUAD_RECORD_WORDS) % 128;
+            record.size = { size(rng), size(rng) };
+            for (uint32_t word : record.pack()) {
+                quad_data.push_back(word);
+            }
+        }
+        sections[section_index + 1] = sections[section_index] + n_quads;
+    }
+    return quad_data;
+}
+
+static std::vector<QuadRecord> unpack_all(const std::vector<uint32_t>& quad_data, size_t first, size_t last) {
+    std::vector<QuadRecord> records;
+    for (size_t i = first; i < last; i++) {
+        records.push_back(QuadRecord::unpack({ quad_data[i * QUAD_RECORD_WORDS], quad_data[i * QUAD_RECORD_WORDS + 1] }));
+    }
+    return records;
+}
+
+static bool same_quads(std::vector<QuadRecord> a, std::vector<QuadRecord> b) {
+    auto pack_order = [](const QuadRecord& x, const QuadRecord& y) { return x.pack() < y.pack(); };
+    std::sort(a.begin(), a.end(), pack_order);
+    std::sort(b.begin(), b.end(), pack_order);
+    return a == b;
+}
+
+// Center of a quad, computed from its corners rather than the way the sorter does it
+static glm::vec3 quad_center(const QuadRecord& record) {
+    glm::vec3 min(record.chunk_pos);
+    glm::vec3 extent(1.0f);
+    int normal_axis = record.face <= VoxelQuad::BOTTOM ? 2 : record.face <= VoxelQuad::RIGHT ? 0 : 1;
+    bool positive_side = record.face == VoxelQuad::TOP || record.face == VoxelQuad::RIGHT || record.face == VoxelQuad::BACK;
+    int u_axis = normal_axis == 0 ? 1 : 0;
+    int v_axis = normal_axis == 2 ? 1 : 2;
+
+    extent[normal_axis] = 0.0f;
+    min[normal_axis] += positive_side ? 1.0f : 0.0f;
+    extent[u_axis] = static_cast<float>(record.size.x);
+    extent[v_axis] = static_cast<float>(record.size.y);
+    return min + 0.5f * extent;
+}
+
+static void test_sort_back_to_front() {
+    std::mt19937 rng(2345);
+    std::uniform_real_distribution<float> camera_coordinate(-20.0f, 280.0f);
+
+    for (int round = 0; round < 20; round++) {
+        SectionQuadOffsets sections{};
+        std::vector<uint32_t> quad_data = random_quads(rng, sections);
+        std::vector<uint32_t> sorted = quad_data;
+        glm::vec3 camera_pos(camera_coordinate(rng) / 10.0f, camera_coordinate(rng) / 10.0f, camera_coordinate(rng));
+        TranslucencySorter::sort_back_to_front(sorted, sections, camera_pos);
+        check(sorted.size() == quad_data.size(), "Sorting keeps every quad");
+
+        for (int section_index = 0; section_index < SECTIONS_PER_CHUNK; section_index++) {
+            std::vector<QuadRecord> before = unpack_all(quad_data, sections[section_index], sections[section_index + 1]);
+            std::vector<QuadRecord> after = unpack_all(sorted, sections[section_index], sections[section_index + 1]);
+            if (!same_quads(before, after)) {
+                check(false, "The quads of section " + std::to_string(section_index) + " are not a permutation");
+                return;
+            }
+
+            for (size_t i = 1; i < after.size(); i++) {
+                glm::vec3 previous = quad_center(after[i - 1]) - camera_pos;
+                glm::vec3 current = quad_center(after[i]) - camera_pos;
+                // with some slack for rounding, since the centers are computed differently
+                if (glm::dot(previous, previous) < glm::dot(current, current) * (1.0f - 1e-5f)) {
+                    check(false, "The quads of section " + std::to_string(section_index) + " are not back to front");
+                    return;
+                }
+            }
+        }
+    }
+}
+
+static void test_jobs_of_a_chunk_coalesce() {
+    TranslucencySorter sorter;
+    std::mt19937 rng(2345);
+
+    // a large job keeps the worker busy while the jobs of the other chunk are queued
+    SectionQuadOffsets busy_sections{};
+    std::vector<uint32_t> busy_quads;
+    for (int i = 0; i < 500; i++) {
+        SectionQuadOffsets sections{};
+        std::vector<uint32_t> quads = random_quads(rng, sections);
+        busy_quads.insert(busy_quads.end(), quads.begin(), quads.end());
+    }
+    busy_sections.fill(0);
+    busy_sections[SECTIONS_PER_CHUNK] = static_cast<uint32_t>(busy_quads.size() / QUAD_RECORD_WORDS);
+    sorter.submit(SortJob{ { 1, 0 }, 1, glm::vec3(0.0f), busy_quads, busy_sections });
+
+    SectionQuadOffsets sections{};
+    std::vector<uint32_t> quads = random_quads(rng, sections);
+    for (uint64_t version = 2; version < 202; version++) {
+        sorter.submit(SortJob{ { 0, 0 }, version, glm::vec3(static_cast<float>(version)), quads, sections });
+    }
+    sorter.wait_idle();
+
+    std::vector<SortResult> results = sorter.take_results();
+    size_t n_results = 0;
+    bool latest = true;
+    for (const SortResult& result : results) {
+        if (result.chunk_coords == glm::ivec2(0, 0)) {
+            n_results++;
+            latest = latest && result.version == 201;
+        }
+    }
+    check(results.size() == 2, "Each chunk gets one result");
+    check(n_results == 1 && latest, "Queued jobs of a chunk are replaced by the latest one");
+    check(sorter.take_results().empty(), "Results are taken once");
+}
+
+int main() {
+    test_sort_back_to_front();
+    test_jobs_of_a_chunk_coalesce();
+    return check_result();
+}